@@ -0,0 +1,349 @@
+#define NG_NO_MAIN
+
+#include <stdarg.h>
+
+#include "main.c"
+
+#define TEST_GZIP_PATH "/tmp/ng_editor_test.txt.gz"
+#define TEST_FOLLOW_PATH "/tmp/ng_editor_test_follow.log"
+#define TEST_RELOAD_PATH "/tmp/ng_editor_test_reload.txt"
+#define TEST_JOURNAL_PATH "/tmp/ng_editor_test_journal.txt"
+#define TEST_SAVE_PATH "/tmp/ng_editor_test_save.txt"
+#define TEST_SAVE_LINK_PATH "/tmp/ng_editor_test_save_link.txt"
+#define TEST_ROWS 24
+#define TEST_COLS 80
+
+EditorLayoutT test_layout;
+
+int test_editor_buffer_open_gzip() {
+	gzFile file = gzopen(TEST_GZIP_PATH, "wb");
+	gzwrite(file, "a\nb\n", 4);
+	gzclose(file);
+
+	EditorBufferT* buffer = editor_buffer_open(TEST_GZIP_PATH);
+	editor_buffer_wait_loaded(buffer);
+
+	size_t size = 0;
+	char* data = line_serialize_lines_from(buffer->head_line, &size);
+
+	int result = 0;
+
+	if (buffer->hex != NULL) {
+		printf("FAIL: test_editor_buffer_open_gzip, expected text view, got hex view\n");
+		result = 1;
+	}
+
+	if (!buffer->compressed) {
+		printf("FAIL: test_editor_buffer_open_gzip, expected buffer to be marked compressed\n");
+		result = 1;
+	}
+
+	if (strcmp("a\nb\n", data)) {
+		printf("FAIL: test_editor_buffer_open_gzip, expected 'a\\nb\\n', got: '%s'\n", data);
+		result = 1;
+	}
+
+	free(data);
+	unlink(TEST_GZIP_PATH);
+
+	return result;
+}
+
+void test_write_file(char* path, char* mode, char* data) {
+	FILE* file = fopen(path, mode);
+	fputs(data, file);
+	fclose(file);
+}
+
+int test_editor_buffer_follow_appends_once() {
+	test_write_file(TEST_FOLLOW_PATH, "w", "a\nb\n");
+
+	EditorBufferT* buffer = editor_buffer_open(TEST_FOLLOW_PATH);
+	editor_buffer_wait_loaded(buffer);
+
+	int result = 0;
+
+	if (buffer->saved_size != 4) {
+		printf("FAIL: test_editor_buffer_follow_appends_once, expected 4 loaded bytes, got: %ld\n", (long)buffer->saved_size);
+		result = 1;
+	}
+
+	editor_buffer_set_follow(buffer, true);
+	test_write_file(TEST_FOLLOW_PATH, "a", "c\n");
+	editor_buffer_follow_disk(buffer);
+	editor_buffer_follow_disk(buffer);
+
+	size_t size = 0;
+	char* data = line_serialize_lines_from(buffer->head_line, &size);
+
+	if (strcmp("a\nb\nc\n", data) || buffer->saved_size != 6) {
+		printf("FAIL: test_editor_buffer_follow_appends_once, expected 'a\\nb\\nc\\n' from 6 bytes, got: '%s' from %ld\n",
+			data, (long)buffer->saved_size);
+		result = 1;
+	}
+
+	free(data);
+	unlink(TEST_FOLLOW_PATH);
+
+	return result;
+}
+
+int test_editor_buffer_reload_case(char* old_str, char* new_str) {
+	test_write_file(TEST_RELOAD_PATH, "w", old_str);
+
+	EditorBufferT* buffer = editor_buffer_open(TEST_RELOAD_PATH);
+	editor_buffer_wait_loaded(buffer);
+
+	test_write_file(TEST_RELOAD_PATH, "w", new_str);
+	editor_buffer_reload(buffer);
+
+	size_t size = 0;
+	char* data = line_serialize_lines_from(buffer->head_line, &size);
+
+	int result = 0;
+
+	if (strcmp(new_str, data)) {
+		printf("FAIL: test_editor_buffer_reload, expected '%s', got: '%s'\n", new_str, data);
+		result = 1;
+	}
+
+	free(data);
+	unlink(TEST_RELOAD_PATH);
+
+	// Forget the buffer so the next case opens the file again.
+	buffer->filename = "";
+
+	return result;
+}
+
+int test_editor_buffer_reload() {
+	int result = 0;
+
+	result |= test_editor_buffer_reload_case("a\nb\n", "a\nb\nc\n");
+	result |= test_editor_buffer_reload_case("a\nb\n", "x\nb\nc\n");
+	result |= test_editor_buffer_reload_case("a\nb\n", "a\nx\n");
+
+	return result;
+}
+
+int test_editor_window_wrap_tall_line() {
+	int length = 20000;
+	int column = 12389;
+	char* text = (char*)malloc(length + 2);
+
+	for (int i = 0; i < length; i++)
+		text[i] = 'a' + i % 26;
+
+	text[length] = '\n';
+	text[length + 1] = 0;
+
+	EditorWindow* window = current_editor_tab->tab_item_current->window;
+	EditorBufferT* buffer = window->editor_buffer;
+	LineT* head_line = line_new_from_str("short\n");
+
+	line_add_next(head_line, line_new_from_str(text));
+	editor_buffer_set_lines(buffer, head_line);
+	editor_config_set_wrap(true);
+
+	int result = 0;
+	int rows = view_rows(window->source_view);
+	int columns[] = {column, column + 1, column - view_cols(window->source_view) * rows, 0};
+
+	for (int i = 0; i < 4; i++) {
+		editor_window_relocate_cursor(window, 1, columns[i]);
+		draw_editor_window_source(window);
+
+		int y = editor_window_cursor_screen_row(window);
+		int x = columns[i] - wrap_layout(window->cursor_line, view_cols(window->source_view))->breaks[editor_window_cursor_wrap_row(window)];
+
+		if (y < 0 || y >= rows) {
+			printf("FAIL: test_editor_window_wrap_tall_line, cursor at column %d is on screen row %d of %d\n", columns[i], y, rows);
+			result = 1;
+
+			continue;
+		}
+
+		char symbol = current_grid[view_y(window->source_view, y)][view_x(window->source_view, x)].symbol;
+
+		if (symbol != text[columns[i]]) {
+			printf("FAIL: test_editor_window_wrap_tall_line, expected '%c' under the cursor at column %d, got: '%c'\n",
+				text[columns[i]], columns[i], symbol);
+			result = 1;
+		}
+	}
+
+	editor_config_set_wrap(false);
+	free(text);
+
+	return result;
+}
+
+uint64_t test_journal_records(int index) {
+	char* path = journal_path_for_index(TEST_JOURNAL_PATH, index);
+	JournalHeader header;
+	uint64_t records_count = 0;
+
+	if (!journal_read_header(path, &header, &records_count))
+		records_count = 0;
+
+	free(path);
+
+	return records_count;
+}
+
+int test_editor_buffer_journal_ignore_and_quit() {
+	test_write_file(TEST_JOURNAL_PATH, "w", "a\n");
+
+	char* path = journal_path_for_index(TEST_JOURNAL_PATH, 0);
+	JournalT* journal = journal_create(path, (JournalHeader){0});
+	journal_append(journal, (JournalRecord){.line = 0, .column = 0, .symbol = 'x'});
+	journal_append(journal, (JournalRecord){.line = 0, .column = 1, .symbol = 'y'});
+	journal_close(journal, false);
+
+	EditorBufferT* buffer = editor_buffer_open(TEST_JOURNAL_PATH);
+	editor_buffer_wait_loaded(buffer);
+
+	journal_prompt_buffer = buffer;
+	editor_buffer_answer_journal('i');
+
+	EditorWindow window = {
+		.editor_buffer = buffer,
+		.cursor_line = buffer->head_line,
+		.cursor_line_item = buffer->head_line->item_head,
+	};
+
+	editor_window_insert_symbol(&window, 'z');
+	editor_buffer_journal_insert(&window, 'z');
+	editor_buffers_close_journals(true);
+
+	int result = 0;
+
+	if (test_journal_records(0) != 2 || test_journal_records(1) != 1) {
+		printf("FAIL: test_editor_buffer_journal_ignore_and_quit, expected 2 and 1 journal records, got: %lu and %lu\n",
+			(unsigned long)test_journal_records(0), (unsigned long)test_journal_records(1));
+		result = 1;
+	}
+
+	for (int i = 0; i < 2; i++) {
+		char* journal_path = journal_path_for_index(TEST_JOURNAL_PATH, i);
+		unlink(journal_path);
+		free(journal_path);
+	}
+
+	free(path);
+	unlink(TEST_JOURNAL_PATH);
+	buffer->filename = "";
+
+	return result;
+}
+
+int test_write_buffer_into_file_hash_collision() {
+	test_write_file(TEST_SAVE_PATH, "w", "a\n");
+
+	EditorBufferT* buffer = editor_buffer_open(TEST_SAVE_PATH);
+	editor_buffer_wait_loaded(buffer);
+
+	// Fake a collision: the saved hash matches the new content.
+	editor_buffer_set_lines(buffer, line_new_from_str("b\n"));
+	editor_buffer_touch(buffer, NULL);
+	buffer->saved_hash = line_hash_lines_from(buffer->head_line);
+	buffer->saved_hash_valid = true;
+
+	write_buffer_into_file(buffer, NULL);
+	io_wait_idle();
+	process_io_results();
+
+	FILE* file = fopen(TEST_SAVE_PATH, "r");
+	char data[16] = {0};
+	fread(data, 1, sizeof(data) - 1, file);
+	fclose(file);
+
+	int result = 0;
+
+	if (strcmp("b\n", data) || buffer->modified) {
+		printf("FAIL: test_write_buffer_into_file_hash_collision, expected 'b\\n' saved, got: '%s'\n", data);
+		result = 1;
+	}
+
+	unlink(TEST_SAVE_PATH);
+	buffer->filename = "";
+
+	return result;
+}
+
+int test_write_buffer_into_file_hard_link() {
+	test_write_file(TEST_SAVE_PATH, "w", "a\n");
+	link(TEST_SAVE_PATH, TEST_SAVE_LINK_PATH);
+
+	EditorBufferT* buffer = editor_buffer_open(TEST_SAVE_PATH);
+	editor_buffer_wait_loaded(buffer);
+
+	editor_buffer_set_lines(buffer, line_new_from_str("b\n"));
+	editor_buffer_touch(buffer, NULL);
+
+	write_buffer_into_file(buffer, NULL);
+	io_wait_idle();
+	process_io_results();
+
+	FILE* file = fopen(TEST_SAVE_LINK_PATH, "r");
+	char data[16] = {0};
+	fread(data, 1, sizeof(data) - 1, file);
+	fclose(file);
+
+	struct stat st;
+	stat(TEST_SAVE_PATH, &st);
+
+	int result = 0;
+
+	if (strcmp("b\n", data) || st.st_nlink != 2) {
+		printf("FAIL: test_write_buffer_into_file_hard_link, expected 'b\\n' through 2 links, got: '%s' through %lu\n",
+			data, (unsigned long)st.st_nlink);
+		result = 1;
+	}
+
+	unlink(TEST_SAVE_LINK_PATH);
+	unlink(TEST_SAVE_PATH);
+	buffer->filename = "";
+
+	return result;
+}
+
+bool run_tests(int n, ...) {
+	va_list args;
+	va_start(args, n);
+	bool failed = false;
+
+	for (int i = 0; i < n; i++) {
+		if (va_arg(args, int(*)())() != 0)
+			failed = true;
+	}
+
+	va_end(args);
+
+	return failed;
+}
+
+int main() {
+	t_backend_set(T_BACKEND_MEMORY);
+	t_set_palette(editor_palette, sizeof(editor_palette) / sizeof(editor_palette[0]));
+	t_grids_init(TEST_ROWS, TEST_COLS);
+	io_start();
+
+	test_layout = editor_layout_new(TEST_ROWS, TEST_COLS);
+	current_editor_tab = init_editor_tab("", test_layout.editor_tab_view);
+
+	bool test_failed = run_tests(7,
+		test_editor_buffer_open_gzip,
+		test_editor_buffer_follow_appends_once,
+		test_editor_buffer_reload,
+		test_editor_window_wrap_tall_line,
+		test_editor_buffer_journal_ignore_and_quit,
+		test_write_buffer_into_file_hash_collision,
+		test_write_buffer_into_file_hard_link
+	);
+
+	if (test_failed)
+		return 1;
+
+	return 0;
+}
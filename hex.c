@@ -0,0 +1,149 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#define HEX_BYTES_PER_ROW 16
+#define HEX_SNIFF_SIZE 8192
+
+typedef struct {
+	int fd;
+	uint8_t* data;
+	size_t size;
+	size_t page_size;
+	uint8_t* dirty_pages;
+	size_t dirty_count;
+} HexT;
+
+bool hex_file_is_binary(char* filename) {
+	uint8_t sniff[HEX_SNIFF_SIZE];
+	int fd = open(filename, O_RDONLY);
+
+	if (fd < 0)
+		return false;
+
+	ssize_t n = read(fd, sniff, sizeof(sniff));
+
+	// gzip headers always hold NUL bytes, judge compressed files by their content.
+	if (n >= 2 && sniff[0] == 0x1f && sniff[1] == 0x8b) {
+		lseek(fd, 0, SEEK_SET);
+
+		gzFile file = gzdopen(fd, "rb");
+
+		if (file == NULL) {
+			close(fd);
+
+			return true;
+		}
+
+		n = gzread(file, sniff, sizeof(sniff));
+		gzclose(file);
+
+		return n < 0 || (n > 0 && memchr(sniff, 0, n) != NULL);
+	}
+
+	close(fd);
+
+	return n > 0 && memchr(sniff, 0, n) != NULL;
+}
+
+HexT* hex_open(char* filename) {
+	int fd = open(filename, O_RDWR);
+
+	if (fd < 0)
+		fd = open(filename, O_RDONLY);
+
+	if (fd < 0)
+		return NULL;
+
+	struct stat st;
+
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+
+		return NULL;
+	}
+
+	HexT* hex = (HexT*)malloc(sizeof(HexT));
+	hex->fd = fd;
+	hex->data = NULL;
+	hex->size = st.st_size;
+	hex->page_size = sysconf(_SC_PAGESIZE);
+	hex->dirty_count = 0;
+
+	if (hex->size > 0) {
+		hex->data = (uint8_t*)mmap(NULL, hex->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+		if (hex->data == MAP_FAILED) {
+			close(fd);
+			free(hex);
+
+			return NULL;
+		}
+	}
+
+	size_t pages = (hex->size + hex->page_size - 1) / hex->page_size;
+	hex->dirty_pages = (uint8_t*)calloc(pages / 8 + 1, 1);
+
+	return hex;
+}
+
+size_t hex_rows(HexT* hex) {
+	return (hex->size + HEX_BYTES_PER_ROW - 1) / HEX_BYTES_PER_ROW;
+}
+
+void hex_set_byte(HexT* hex, size_t offset, uint8_t value) {
+	if (offset >= hex->size || hex->data[offset] == value)
+		return;
+
+	hex->data[offset] = value;
+
+	size_t page = offset / hex->page_size;
+
+	if (!(hex->dirty_pages[page / 8] & (1 << (page % 8)))) {
+		hex->dirty_pages[page / 8] |= 1 << (page % 8);
+		hex->dirty_count++;
+	}
+}
+
+int hex_save(HexT* hex, size_t* pages_written) {
+	size_t pages = (hex->size + hex->page_size - 1) / hex->page_size;
+
+	*pages_written = 0;
+
+	for (size_t page = 0; page < pages; page++) {
+		if (!(hex->dirty_pages[page / 8] & (1 << (page % 8))))
+			continue;
+
+		size_t from = page * hex->page_size;
+		size_t len = hex->size - from < hex->page_size ? hex->size - from : hex->page_size;
+
+		if (pwrite(hex->fd, hex->data + from, len, from) != (ssize_t)len)
+			return errno;
+
+		hex->dirty_pages[page / 8] &= ~(1 << (page % 8));
+		(*pages_written)++;
+	}
+
+	hex->dirty_count = 0;
+
+	if (*pages_written > 0 && fsync(hex->fd) < 0)
+		return errno;
+
+	return 0;
+}
+
+void hex_close(HexT* hex) {
+	if (hex->data != NULL)
+		munmap(hex->data, hex->size);
+
+	close(hex->fd);
+	free(hex->dirty_pages);
+	free(hex);
+}
@@ -0,0 +1,456 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "calc.h"
+
+#define IO_CHUNK_SIZE (64 * 1024)
+#define IO_MAX_WORKERS 8
+
+typedef enum {
+	IO_JOB_WRITE,
+	IO_JOB_READ,
+} IoJobType;
+
+typedef struct IoJob {
+	IoJobType type;
+	char* filename;
+	char* data;
+	size_t size;
+	bool compress;
+	void* owner;
+	void* batch;
+	void* (*load)(char* filename, bool* compressed);
+	void* result;
+	uint64_t content_hash;
+	uint64_t data_hash;
+	uint64_t version;
+	uint64_t journal_checkpoint;
+	int error;
+	struct IoJob* next;
+} IoJobT;
+
+typedef struct {
+	IoJobT* head;
+	IoJobT* tail;
+} IoJobQueue;
+
+static pthread_t io_threads[IO_MAX_WORKERS];
+static void* io_running_owners[IO_MAX_WORKERS];
+static int io_workers_count = 0;
+static pthread_mutex_t io_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t io_job_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t io_idle_cond = PTHREAD_COND_INITIALIZER;
+
+static IoJobQueue io_pending = {};
+static IoJobQueue io_done = {};
+static int io_in_flight = 0;
+static int io_notify_pipe[2] = {-1, -1};
+
+static void io_queue_push(IoJobQueue* queue, IoJobT* job) {
+	job->next = NULL;
+
+	if (queue->tail == NULL) {
+		queue->head = job;
+	} else {
+		queue->tail->next = job;
+	}
+
+	queue->tail = job;
+}
+
+static IoJobT* io_queue_pop(IoJobQueue* queue) {
+	IoJobT* job = queue->head;
+
+	if (job == NULL)
+		return NULL;
+
+	queue->head = job->next;
+
+	if (queue->head == NULL)
+		queue->tail = NULL;
+
+	return job;
+}
+
+static bool io_owner_is_running(void* owner) {
+	for (int i = 0; i < io_workers_count; i++) {
+		if (io_running_owners[i] == owner)
+			return true;
+	}
+
+	return false;
+}
+
+static IoJobT* io_queue_pop_runnable(IoJobQueue* queue) {
+	bool has_writes = false;
+
+	for (IoJobT* job = queue->head; job != NULL && !has_writes; job = job->next)
+		has_writes = job->type == IO_JOB_WRITE && !io_owner_is_running(job->owner);
+
+	IoJobT* prev = NULL;
+
+	for (IoJobT* job = queue->head; job != NULL; prev = job, job = job->next) {
+		if ((job->owner != NULL && io_owner_is_running(job->owner)) || (has_writes && job->type != IO_JOB_WRITE))
+			continue;
+
+		if (prev == NULL)
+			queue->head = job->next;
+		else
+			prev->next = job->next;
+
+		if (queue->tail == job)
+			queue->tail = prev;
+
+		return job;
+	}
+
+	return NULL;
+}
+
+static int io_write_file_compressed(IoJobT* job, int fd) {
+	int gz_fd = dup(fd);
+
+	if (gz_fd < 0)
+		return errno;
+
+	gzFile file = gzdopen(gz_fd, "wb");
+
+	if (file == NULL) {
+		close(gz_fd);
+
+		return ENOMEM;
+	}
+
+	gzbuffer(file, IO_CHUNK_SIZE);
+
+	size_t written = 0;
+
+	while (written < job->size) {
+		unsigned chunk = MIN(IO_CHUNK_SIZE, job->size - written);
+
+		if (gzwrite(file, job->data + written, chunk) != (int)chunk) {
+			gzclose(file);
+
+			return errno != 0 ? errno : EIO;
+		}
+
+		written += chunk;
+	}
+
+	if (gzclose(file) != Z_OK)
+		return errno != 0 ? errno : EIO;
+
+	return 0;
+}
+
+static int io_write_file_plain(IoJobT* job, int fd) {
+	size_t written = 0;
+
+	while (written < job->size) {
+		ssize_t n = write(fd, job->data + written, job->size - written);
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+
+			return errno;
+		}
+
+		written += n;
+	}
+
+	return 0;
+}
+
+static char* io_temp_path_for(char* filename) {
+	static int counter = 0;
+
+	char* slash = strrchr(filename, '/');
+	int dir_len = slash == NULL ? 0 : slash - filename + 1;
+	char* base = filename + dir_len;
+
+	size_t size = strlen(filename) + strlen(".ngtmp") + 48;
+	char* path = (char*)malloc(size);
+	snprintf(path, size, "%.*s.%s.ngtmp.%d.%d", dir_len, filename, base, (int)getpid(), __atomic_fetch_add(&counter, 1, __ATOMIC_RELAXED));
+
+	return path;
+}
+
+static int io_write_file_data(IoJobT* job, int fd) {
+	return job->compress ? io_write_file_compressed(job, fd) : io_write_file_plain(job, fd);
+}
+
+static int io_write_file_in_place(IoJobT* job, char* target) {
+	int fd = open(target, O_WRONLY | O_TRUNC);
+
+	if (fd < 0)
+		return errno;
+
+	int error = io_write_file_data(job, fd);
+
+	if (error == 0 && fsync(fd) < 0)
+		error = errno;
+
+	if (close(fd) < 0 && error == 0)
+		error = errno;
+
+	return error;
+}
+
+// Writes go to a temp file next to the target which is renamed over it only
+// after the data is on disk, so a failed or interrupted save never truncates
+// the original. A rename would split hard links or change the owner, such
+// files are written in place instead.
+static int io_write_file(IoJobT* job) {
+	char* target = realpath(job->filename, NULL);
+
+	if (target == NULL)
+		target = strdup(job->filename);
+
+	struct stat st;
+	bool exists = stat(target, &st) == 0;
+
+	if (exists && st.st_nlink > 1) {
+		int error = io_write_file_in_place(job, target);
+		free(target);
+
+		return error;
+	}
+
+	char* temp_path = io_temp_path_for(target);
+	int fd = open(temp_path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+
+	if (fd < 0) {
+		int error = errno;
+		free(temp_path);
+		free(target);
+
+		return error;
+	}
+
+	int error = 0;
+
+	if (exists && fchown(fd, st.st_uid, st.st_gid) < 0) {
+		close(fd);
+		unlink(temp_path);
+		free(temp_path);
+
+		error = io_write_file_in_place(job, target);
+		free(target);
+
+		return error;
+	}
+
+	if (exists && fchmod(fd, st.st_mode & 07777) < 0)
+		error = errno;
+
+	if (error == 0)
+		error = io_write_file_data(job, fd);
+
+	if (error == 0 && fsync(fd) < 0)
+		error = errno;
+
+	if (close(fd) < 0 && error == 0)
+		error = errno;
+
+	if (error == 0 && rename(temp_path, target) < 0)
+		error = errno;
+
+	if (error != 0)
+		unlink(temp_path);
+
+	free(temp_path);
+	free(target);
+
+	return error;
+}
+
+static void* io_thread_main(void* arg) {
+	int worker = (int)(intptr_t)arg;
+
+	while (true) {
+		pthread_mutex_lock(&io_mutex);
+
+		IoJobT* job;
+
+		while ((job = io_queue_pop_runnable(&io_pending)) == NULL)
+			pthread_cond_wait(&io_job_cond, &io_mutex);
+
+		io_running_owners[worker] = job->owner;
+
+		pthread_mutex_unlock(&io_mutex);
+
+		switch (job->type) {
+			case IO_JOB_WRITE:
+				job->error = io_write_file(job);
+				break;
+
+			case IO_JOB_READ:
+				job->result = job->load(job->filename, &job->compress);
+				break;
+		}
+
+		pthread_mutex_lock(&io_mutex);
+
+		io_running_owners[worker] = NULL;
+		io_queue_push(&io_done, job);
+		io_in_flight--;
+
+		if (io_in_flight == 0)
+			pthread_cond_broadcast(&io_idle_cond);
+
+		if (io_pending.head != NULL)
+			pthread_cond_broadcast(&io_job_cond);
+
+		pthread_mutex_unlock(&io_mutex);
+
+		char byte = 1;
+		write(io_notify_pipe[1], &byte, 1);
+	}
+
+	return NULL;
+}
+
+void io_start() {
+	pipe(io_notify_pipe);
+	fcntl(io_notify_pipe[0], F_SETFL, O_NONBLOCK);
+
+	io_workers_count = MAX(1, MIN(IO_MAX_WORKERS, sysconf(_SC_NPROCESSORS_ONLN)));
+
+	for (int i = 0; i < io_workers_count; i++)
+		pthread_create(&io_threads[i], NULL, io_thread_main, (void*)(intptr_t)i);
+}
+
+int io_workers() {
+	return io_workers_count;
+}
+
+int io_notify_fd() {
+	return io_notify_pipe[0];
+}
+
+IoJobT* io_job_new_write(char* filename, char* data, size_t size, void* owner) {
+	IoJobT* job = (IoJobT*)malloc(sizeof(IoJobT));
+	job->type = IO_JOB_WRITE;
+	job->filename = strdup(filename);
+	job->data = data;
+	job->size = size;
+	job->compress = false;
+	job->owner = owner;
+	job->batch = NULL;
+	job->load = NULL;
+	job->result = NULL;
+	job->content_hash = 0;
+	job->data_hash = 0;
+	job->version = 0;
+	job->journal_checkpoint = 0;
+	job->error = 0;
+
+	return job;
+}
+
+IoJobT* io_job_new_read(char* filename, void* (*load)(char* filename, bool* compressed), void* owner) {
+	IoJobT* job = io_job_new_write(filename, NULL, 0, owner);
+	job->type = IO_JOB_READ;
+	job->load = load;
+
+	return job;
+}
+
+void io_submit(IoJobT* job) {
+	pthread_mutex_lock(&io_mutex);
+
+	io_queue_push(&io_pending, job);
+	io_in_flight++;
+
+	pthread_cond_signal(&io_job_cond);
+	pthread_mutex_unlock(&io_mutex);
+}
+
+void io_wait_idle() {
+	pthread_mutex_lock(&io_mutex);
+
+	while (io_in_flight > 0)
+		pthread_cond_wait(&io_idle_cond, &io_mutex);
+
+	pthread_mutex_unlock(&io_mutex);
+}
+
+IoJobT* io_take_done() {
+	char bytes[64];
+
+	while (read(io_notify_pipe[0], bytes, sizeof(bytes)) > 0);
+
+	pthread_mutex_lock(&io_mutex);
+
+	IoJobT* job = io_queue_pop(&io_done);
+
+	pthread_mutex_unlock(&io_mutex);
+
+	return job;
+}
+
+void io_job_free(IoJobT* job) {
+	free(job->filename);
+	free(job->data);
+	free(job);
+}
+
+// Compares the file content (decompressed when compressed) byte for byte
+// with data, used to confirm a content hash match before skipping a save.
+bool io_file_matches(char* filename, bool compressed, char* data, size_t size) {
+	int fd = open(filename, O_RDONLY);
+
+	if (fd < 0)
+		return false;
+
+	gzFile file = NULL;
+
+	if (compressed) {
+		file = gzdopen(fd, "rb");
+
+		if (file == NULL) {
+			close(fd);
+
+			return false;
+		}
+	}
+
+	char* chunk = (char*)malloc(IO_CHUNK_SIZE);
+	size_t offset = 0;
+	bool matches = true;
+
+	while (matches) {
+		ssize_t n = compressed ? gzread(file, chunk, IO_CHUNK_SIZE) : read(fd, chunk, IO_CHUNK_SIZE);
+
+		if (n < 0 && !compressed && errno == EINTR)
+			continue;
+
+		if (n <= 0) {
+			matches = n == 0 && offset == size;
+
+			break;
+		}
+
+		matches = (size_t)n <= size - offset && memcmp(chunk, data + offset, n) == 0;
+		offset += n;
+	}
+
+	free(chunk);
+
+	if (compressed)
+		gzclose(file);
+	else
+		close(fd);
+
+	return matches;
+}
@@ -0,0 +1,85 @@
+#define NG_NO_MAIN
+
+#include "main.c"
+
+#define BENCH_PLAIN_PATH "/tmp/ng_io_bench.log"
+#define BENCH_GZIP_PATH "/tmp/ng_io_bench.log.gz"
+#define BENCH_LINES 500000
+
+double bench_now_ms() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+void bench_write_sources() {
+	FILE* plain_file = fopen(BENCH_PLAIN_PATH, "w");
+	gzFile gzip_file = gzopen(BENCH_GZIP_PATH, "wb");
+
+	for (int i = 0; i < BENCH_LINES; i++) {
+		char line[256];
+		int len = snprintf(line, sizeof(line), "2026-10-18T12:%02d:%02d.%06d INFO worker-%d request %d handled in %dms\n",
+			(i / 60) % 60, i % 60, i, i % 16, i * 7, i % 250);
+
+		fwrite(line, 1, len, plain_file);
+		gzwrite(gzip_file, line, len);
+	}
+
+	fclose(plain_file);
+	gzclose(gzip_file);
+}
+
+off_t bench_file_size(char* path) {
+	struct stat st;
+	stat(path, &st);
+
+	return st.st_size;
+}
+
+void bench_load_and_save(char* path, char* label) {
+	EditorBufferT* buffer = editor_buffer_new();
+	buffer->filename = path;
+
+	double started = bench_now_ms();
+	buffer->head_line = read_and_parse_source_file(path, &buffer->compressed);
+	double load_elapsed = bench_now_ms() - started;
+
+	size_t size = 0;
+	char* data = line_serialize_lines_from(buffer->head_line, &size);
+
+	IoJobT* job = io_job_new_write(path, data, size, buffer);
+	job->compress = buffer->compressed;
+
+	started = bench_now_ms();
+	int error = io_write_file(job);
+	double save_elapsed = bench_now_ms() - started;
+
+	printf("%-6s %9ld bytes on disk, %9zu bytes of text: load %8.2f ms (%7.2f MB/s), save %8.2f ms (%7.2f MB/s)%s\n",
+		label,
+		(long)bench_file_size(path),
+		size,
+		load_elapsed,
+		size / load_elapsed / 1000.0,
+		save_elapsed,
+		size / save_elapsed / 1000.0,
+		error != 0 ? " FAILED" : "");
+
+	io_job_free(job);
+	line_free(buffer->head_line);
+}
+
+int main() {
+	bench_write_sources();
+
+	bool compressed;
+	line_free(read_and_parse_source_file(BENCH_PLAIN_PATH, &compressed));
+
+	bench_load_and_save(BENCH_GZIP_PATH, "gzip");
+	bench_load_and_save(BENCH_PLAIN_PATH, "plain");
+
+	unlink(BENCH_PLAIN_PATH);
+	unlink(BENCH_GZIP_PATH);
+
+	return 0;
+}
@@ -0,0 +1,376 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "calc.h"
+
+#define JOURNAL_MAGIC "NGSWP001"
+#define JOURNAL_MAGIC_SIZE 8
+#define JOURNAL_HEADER_SIZE (JOURNAL_MAGIC_SIZE + 3 * sizeof(int64_t))
+#define JOURNAL_RECORD_SIZE (2 * sizeof(uint32_t) + 1)
+#define JOURNAL_BUFFER_SIZE (64 * 1024)
+#define JOURNAL_FSYNC_INTERVAL_MS 1000
+#define JOURNAL_MAX_FILES 10
+
+typedef struct {
+	uint32_t line;
+	uint32_t column;
+	char symbol;
+} JournalRecord;
+
+typedef struct {
+	int64_t source_size;
+	int64_t source_mtime_sec;
+	int64_t source_mtime_nsec;
+} JournalHeader;
+
+typedef struct Journal {
+	int fd;
+	char* path;
+	char buffer[JOURNAL_BUFFER_SIZE];
+	size_t buffer_size;
+	uint64_t records_count;
+	bool needs_fsync;
+	pthread_mutex_t mutex;
+	struct Journal* next;
+} JournalT;
+
+static pthread_t journal_thread;
+static pthread_mutex_t journal_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+static JournalT* journals = NULL;
+static bool journal_thread_started = false;
+
+// Index 0 is the primary journal, later ones hold the edits of sessions that
+// left an older journal alone.
+char* journal_path_for_index(char* filename, int index) {
+	char* slash = strrchr(filename, '/');
+	int dir_len = slash == NULL ? 0 : slash - filename + 1;
+	char* base = filename + dir_len;
+
+	char* path = (char*)malloc(strlen(filename) + strlen(".ngswp") + 16);
+
+	if (index == 0)
+		sprintf(path, "%.*s.%s.ngswp", dir_len, filename, base);
+	else
+		sprintf(path, "%.*s.%s.ngswp.%d", dir_len, filename, base, index);
+
+	return path;
+}
+
+char* journal_path_for(char* filename) {
+	return journal_path_for_index(filename, 0);
+}
+
+static int journal_write_all(int fd, char* data, size_t size) {
+	size_t written = 0;
+
+	while (written < size) {
+		ssize_t n = write(fd, data + written, size - written);
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+
+			return -1;
+		}
+
+		written += n;
+	}
+
+	return 0;
+}
+
+static void journal_header_encode(char* out, JournalHeader* header) {
+	memcpy(out, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE);
+	memcpy(out + JOURNAL_MAGIC_SIZE, &header->source_size, sizeof(int64_t));
+	memcpy(out + JOURNAL_MAGIC_SIZE + sizeof(int64_t), &header->source_mtime_sec, sizeof(int64_t));
+	memcpy(out + JOURNAL_MAGIC_SIZE + 2 * sizeof(int64_t), &header->source_mtime_nsec, sizeof(int64_t));
+}
+
+static void journal_flush_locked(JournalT* journal) {
+	if (journal->buffer_size == 0)
+		return;
+
+	journal_write_all(journal->fd, journal->buffer, journal->buffer_size);
+
+	journal->buffer_size = 0;
+	journal->needs_fsync = true;
+}
+
+static void* journal_thread_main(void* arg) {
+	struct timespec interval = {
+		.tv_sec = JOURNAL_FSYNC_INTERVAL_MS / 1000,
+		.tv_nsec = (JOURNAL_FSYNC_INTERVAL_MS % 1000) * 1000000L,
+	};
+
+	int* fds = NULL;
+	int fds_capacity = 0;
+
+	while (true) {
+		nanosleep(&interval, NULL);
+
+		int fds_count = 0;
+
+		pthread_mutex_lock(&journal_list_mutex);
+
+		for (JournalT* journal = journals; journal != NULL; journal = journal->next) {
+			pthread_mutex_lock(&journal->mutex);
+
+			journal_flush_locked(journal);
+
+			if (journal->needs_fsync) {
+				if (fds_count == fds_capacity) {
+					fds_capacity = MAX(8, fds_capacity * 2);
+					fds = (int*)realloc(fds, sizeof(int) * fds_capacity);
+				}
+
+				int fd = dup(journal->fd);
+
+				if (fd >= 0)
+					fds[fds_count++] = fd;
+
+				journal->needs_fsync = false;
+			}
+
+			pthread_mutex_unlock(&journal->mutex);
+		}
+
+		pthread_mutex_unlock(&journal_list_mutex);
+
+		for (int i = 0; i < fds_count; i++) {
+			fsync(fds[i]);
+			close(fds[i]);
+		}
+	}
+
+	return NULL;
+}
+
+static void journal_register(JournalT* journal) {
+	pthread_mutex_lock(&journal_list_mutex);
+
+	journal->next = journals;
+	journals = journal;
+
+	if (!journal_thread_started) {
+		pthread_create(&journal_thread, NULL, journal_thread_main, NULL);
+		journal_thread_started = true;
+	}
+
+	pthread_mutex_unlock(&journal_list_mutex);
+}
+
+static void journal_unregister(JournalT* journal) {
+	pthread_mutex_lock(&journal_list_mutex);
+
+	JournalT** link = &journals;
+
+	while (*link != NULL && *link != journal)
+		link = &(*link)->next;
+
+	if (*link != NULL)
+		*link = journal->next;
+
+	pthread_mutex_unlock(&journal_list_mutex);
+}
+
+static JournalT* journal_new(int fd, char* path, uint64_t records_count) {
+	JournalT* journal = (JournalT*)malloc(sizeof(JournalT));
+	journal->fd = fd;
+	journal->path = path;
+	journal->buffer_size = 0;
+	journal->records_count = records_count;
+	journal->needs_fsync = false;
+	journal->next = NULL;
+	pthread_mutex_init(&journal->mutex, NULL);
+
+	journal_register(journal);
+
+	return journal;
+}
+
+JournalT* journal_create(char* path, JournalHeader header) {
+	int fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_APPEND, 0600);
+
+	if (fd < 0)
+		return NULL;
+
+	char encoded[JOURNAL_HEADER_SIZE];
+	journal_header_encode(encoded, &header);
+
+	if (journal_write_all(fd, encoded, JOURNAL_HEADER_SIZE) < 0) {
+		close(fd);
+		unlink(path);
+
+		return NULL;
+	}
+
+	return journal_new(fd, strdup(path), 0);
+}
+
+JournalT* journal_open_append(char* path, uint64_t records_count) {
+	int fd = open(path, O_WRONLY | O_APPEND);
+
+	if (fd < 0)
+		return NULL;
+
+	return journal_new(fd, strdup(path), records_count);
+}
+
+void journal_append(JournalT* journal, JournalRecord record) {
+	pthread_mutex_lock(&journal->mutex);
+
+	if (journal->buffer_size + JOURNAL_RECORD_SIZE > JOURNAL_BUFFER_SIZE)
+		journal_flush_locked(journal);
+
+	char* out = journal->buffer + journal->buffer_size;
+	memcpy(out, &record.line, sizeof(uint32_t));
+	memcpy(out + sizeof(uint32_t), &record.column, sizeof(uint32_t));
+	out[2 * sizeof(uint32_t)] = record.symbol;
+
+	journal->buffer_size += JOURNAL_RECORD_SIZE;
+	journal->records_count++;
+
+	pthread_mutex_unlock(&journal->mutex);
+}
+
+void journal_sync(JournalT* journal) {
+	pthread_mutex_lock(&journal->mutex);
+
+	journal_flush_locked(journal);
+	fsync(journal->fd);
+	journal->needs_fsync = false;
+
+	pthread_mutex_unlock(&journal->mutex);
+}
+
+void journal_rebase(JournalT* journal, uint64_t checkpoint, JournalHeader header) {
+	pthread_mutex_lock(&journal->mutex);
+
+	journal_flush_locked(journal);
+
+	uint64_t kept_count = journal->records_count - MIN(checkpoint, journal->records_count);
+	size_t kept_size = kept_count * JOURNAL_RECORD_SIZE;
+	char* kept = (char*)malloc(JOURNAL_HEADER_SIZE + kept_size);
+	off_t kept_offset = JOURNAL_HEADER_SIZE + (journal->records_count - kept_count) * JOURNAL_RECORD_SIZE;
+
+	journal_header_encode(kept, &header);
+
+	int read_fd = open(journal->path, O_RDONLY);
+
+	if (read_fd >= 0) {
+		if (pread(read_fd, kept + JOURNAL_HEADER_SIZE, kept_size, kept_offset) != (ssize_t)kept_size)
+			kept_count = 0;
+
+		close(read_fd);
+	} else {
+		kept_count = 0;
+	}
+
+	ftruncate(journal->fd, 0);
+	journal_write_all(journal->fd, kept, JOURNAL_HEADER_SIZE + kept_count * JOURNAL_RECORD_SIZE);
+
+	journal->records_count = kept_count;
+	journal->needs_fsync = true;
+
+	free(kept);
+
+	pthread_mutex_unlock(&journal->mutex);
+}
+
+void journal_close(JournalT* journal, bool remove) {
+	journal_unregister(journal);
+
+	pthread_mutex_lock(&journal->mutex);
+
+	if (remove || journal->records_count == 0) {
+		unlink(journal->path);
+	} else {
+		journal_flush_locked(journal);
+		fsync(journal->fd);
+	}
+
+	close(journal->fd);
+
+	pthread_mutex_unlock(&journal->mutex);
+	pthread_mutex_destroy(&journal->mutex);
+
+	free(journal->path);
+	free(journal);
+}
+
+bool journal_read_header(char* path, JournalHeader* header, uint64_t* records_count) {
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0)
+		return false;
+
+	char encoded[JOURNAL_HEADER_SIZE];
+	off_t size = lseek(fd, 0, SEEK_END);
+
+	bool valid = size >= JOURNAL_HEADER_SIZE &&
+		pread(fd, encoded, JOURNAL_HEADER_SIZE, 0) == JOURNAL_HEADER_SIZE &&
+		!memcmp(encoded, JOURNAL_MAGIC, JOURNAL_MAGIC_SIZE);
+
+	close(fd);
+
+	if (!valid)
+		return false;
+
+	memcpy(&header->source_size, encoded + JOURNAL_MAGIC_SIZE, sizeof(int64_t));
+	memcpy(&header->source_mtime_sec, encoded + JOURNAL_MAGIC_SIZE + sizeof(int64_t), sizeof(int64_t));
+	memcpy(&header->source_mtime_nsec, encoded + JOURNAL_MAGIC_SIZE + 2 * sizeof(int64_t), sizeof(int64_t));
+	*records_count = (size - JOURNAL_HEADER_SIZE) / JOURNAL_RECORD_SIZE;
+
+	return true;
+}
+
+uint64_t journal_replay(char* path, void (*apply)(JournalRecord*, void*), void* context) {
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0)
+		return 0;
+
+	char chunk[JOURNAL_RECORD_SIZE * 4096];
+	size_t chunk_size = 0;
+	uint64_t applied = 0;
+
+	lseek(fd, JOURNAL_HEADER_SIZE, SEEK_SET);
+
+	while (true) {
+		ssize_t n = read(fd, chunk + chunk_size, sizeof(chunk) - chunk_size);
+
+		if (n <= 0)
+			break;
+
+		chunk_size += n;
+
+		size_t offset = 0;
+
+		while (chunk_size - offset >= JOURNAL_RECORD_SIZE) {
+			JournalRecord record;
+			memcpy(&record.line, chunk + offset, sizeof(uint32_t));
+			memcpy(&record.column, chunk + offset + sizeof(uint32_t), sizeof(uint32_t));
+			record.symbol = chunk[offset + 2 * sizeof(uint32_t)];
+
+			apply(&record, context);
+
+			offset += JOURNAL_RECORD_SIZE;
+			applied++;
+		}
+
+		memmove(chunk, chunk + offset, chunk_size - offset);
+		chunk_size -= offset;
+	}
+
+	close(fd);
+
+	return applied;
+}
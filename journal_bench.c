@@ -0,0 +1,99 @@
+#define NG_NO_MAIN
+
+#include "main.c"
+
+#define BENCH_SOURCE_PATH "/tmp/ng_journal_bench.txt"
+#define BENCH_SOURCE_LINES 1000
+
+double bench_now_ms() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+void bench_write_source() {
+	FILE* source_file = fopen(BENCH_SOURCE_PATH, "w");
+
+	for (int i = 0; i < BENCH_SOURCE_LINES; i++)
+		fprintf(source_file, "line %d\tof the journal replay benchmark source\n", i);
+
+	fclose(source_file);
+}
+
+void bench_write_journal(char* path, uint64_t records_count) {
+	JournalHeader header = {};
+	JournalT* journal = journal_create(path, header);
+
+	uint32_t line = 0;
+	uint32_t column = 0;
+
+	for (uint64_t i = 0; i < records_count; i++) {
+		if (rand() % 40 == 0) {
+			line = rand() % BENCH_SOURCE_LINES;
+			column = rand() % 40;
+		}
+
+		char symbol = 'a' + rand() % 26;
+		int kind = rand() % 20;
+
+		if (kind == 0) {
+			symbol = '\n';
+			line++;
+			column = 0;
+		} else if (kind == 1) {
+			symbol = 127;
+			column = column > 0 ? column - 1 : 0;
+		} else {
+			column++;
+		}
+
+		JournalRecord record = {.line = line, .column = column, .symbol = symbol};
+		journal_append(journal, record);
+	}
+
+	journal_close(journal, false);
+}
+
+void bench_replay(uint64_t records_count) {
+	char* path = journal_path_for(BENCH_SOURCE_PATH);
+
+	unlink(path);
+	bench_write_journal(path, records_count);
+
+	struct stat st;
+	stat(path, &st);
+
+	EditorBufferT* buffer = editor_buffer_new();
+	buffer->filename = BENCH_SOURCE_PATH;
+	buffer->head_line = read_and_parse_source_file(BENCH_SOURCE_PATH, &buffer->compressed);
+
+	double started = bench_now_ms();
+	uint64_t replayed = editor_buffer_replay_journal(buffer, path);
+	double elapsed = bench_now_ms() - started;
+
+	printf("journal replay: %8lu records, %10ld bytes, %9.2f ms, %7.2f Mrecords/s, %7.2f MB/s\n",
+		(unsigned long)replayed,
+		(long)st.st_size,
+		elapsed,
+		replayed / elapsed / 1000.0,
+		st.st_size / elapsed / 1000.0);
+
+	unlink(path);
+	free(path);
+}
+
+int main() {
+	srand(1);
+
+	bench_write_source();
+
+	bench_replay(1000);
+	bench_replay(10000);
+	bench_replay(100000);
+	bench_replay(1000000);
+
+	unlink(BENCH_SOURCE_PATH);
+
+	return 0;
+}
@@ -1,7 +1,12 @@
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#define LINE_HASH_OFFSET 14695981039346656037ULL
+#define LINE_HASH_PRIME 1099511628211ULL
+
 typedef struct LineItem {
 	char symbol;
 	struct LineItem* next;
@@ -10,13 +15,25 @@ typedef struct LineItem {
 
 typedef struct Line {
 	LineItemT* item_head;
+	uint64_t id;
+	uint32_t version;
+	uint64_t hash;
+	bool hash_valid;
+	uint8_t syntax_start;
+	uint8_t syntax_end;
+	bool syntax_valid;
+	uint32_t syntax_epoch;
 	struct Line* next;
 	struct Line* prev;
 } LineT;
 
+static uint64_t line_id_counter = 0;
+
 LineItemT* line_item_new(char symbol) {
 	LineItemT* line_item = (LineItemT*)malloc(sizeof(LineItemT));
 	line_item->symbol = symbol;
+	line_item->next = NULL;
+	line_item->prev = NULL;
 
 	return line_item;
 }
@@ -86,6 +103,16 @@ void line_item_remove_next(LineItemT* line_head) {
 LineT* line_new(LineItemT* line_head) {
 	LineT* line = (LineT*)malloc(sizeof(LineT));
 	line->item_head = line_head;
+	line->id = __atomic_add_fetch(&line_id_counter, 1, __ATOMIC_RELAXED);
+	line->version = 0;
+	line->hash = 0;
+	line->hash_valid = false;
+	line->syntax_start = 0;
+	line->syntax_end = 0;
+	line->syntax_valid = false;
+	line->syntax_epoch = 0;
+	line->next = NULL;
+	line->prev = NULL;
 
 	return line;
 }
@@ -120,6 +147,65 @@ int line_symbols_count(LineT* line) {
 	return result;
 }
 
+void line_touch(LineT* line) {
+	line->hash_valid = false;
+	line->syntax_valid = false;
+	line->version++;
+}
+
+uint64_t line_hash(LineT* line) {
+	if (line->hash_valid)
+		return line->hash;
+
+	uint64_t hash = LINE_HASH_OFFSET;
+
+	for (LineItemT* item = line->item_head; item != NULL; item = item->next) {
+		hash ^= (unsigned char)item->symbol;
+		hash *= LINE_HASH_PRIME;
+	}
+
+	line->hash = hash;
+	line->hash_valid = true;
+
+	return hash;
+}
+
+uint64_t line_hash_bytes(uint64_t hash, char* data, size_t size) {
+	for (size_t i = 0; i < size; i++) {
+		hash ^= (unsigned char)data[i];
+		hash *= LINE_HASH_PRIME;
+	}
+
+	return hash;
+}
+
+bool line_equal(LineT* a, LineT* b) {
+	if (line_hash(a) != line_hash(b))
+		return false;
+
+	LineItemT* item_a = a->item_head;
+	LineItemT* item_b = b->item_head;
+
+	while (item_a != NULL && item_b != NULL && item_a->symbol == item_b->symbol) {
+		item_a = item_a->next;
+		item_b = item_b->next;
+	}
+
+	return item_a == NULL && item_b == NULL;
+}
+
+uint64_t line_hash_lines_from(LineT* line) {
+	uint64_t hash = LINE_HASH_OFFSET;
+
+	while (line != NULL) {
+		hash ^= line_hash(line);
+		hash *= LINE_HASH_PRIME;
+		line = line->next;
+	}
+
+	return hash;
+}
+
 LineT* line_new_from_str(char* str) {
 	LineT* line = line_new(NULL);
 	LineItemT* line_item = NULL;
@@ -145,17 +231,45 @@ LineT* line_new_from_str(char* str) {
 
 char* line_to_str(LineT* line) {
 	int line_str_len = line_symbols_count(line) + 1;
-	char* str = (char*)malloc(sizeof(char) * line_str_len);
+	char* str = (char*)malloc(sizeof(char) * (line_str_len + 1));
 	LineItemT* line_item = line->item_head;
+	int i = 0;
 
 	while (line_item != NULL) {
-		sprintf(str, "%s%c", str, line_item->symbol);
+		str[i] = line_item->symbol;
 		line_item = line_item->next;
+		i++;
 	}
 
+	str[i] = '\0';
+
 	return str;
 }
 
+char* line_serialize_lines_from(LineT* line, size_t* size) {
+	size_t total = 0;
+
+	for (LineT* l = line; l != NULL; l = l->next) {
+		for (LineItemT* item = l->item_head; item != NULL; item = item->next)
+			total++;
+	}
+
+	char* data = (char*)malloc(sizeof(char) * (total + 1));
+	size_t i = 0;
+
+	for (LineT* l = line; l != NULL; l = l->next) {
+		for (LineItemT* item = l->item_head; item != NULL; item = item->next) {
+			data[i] = item->symbol;
+			i++;
+		}
+	}
+
+	data[i] = '\0';
+	*size = total;
+
+	return data;
+}
+
 LineT* line_copy(LineT* line) {
 	if (line == NULL)
 		return NULL;
@@ -257,6 +371,7 @@ void line_delete_after(LineT** line) {
 	if (l->next != NULL)
 		l->next->prev = l;
 
+	line_to_free->next = NULL;
 	line_free(line_to_free);
 }
 
@@ -270,6 +385,7 @@ void line_delete_before(LineT* line) {
 	if (line->prev != NULL)
 		line->prev->next = line;
 
+	line_to_free->next = NULL;
 	line_free(line_to_free);
 }
 
@@ -314,3 +430,147 @@ void line_new_after(LineT** line) {
 	new_line->prev = l;
 	l->next = new_line;
 }
+
+LineT* line_find_tail(LineT* line) {
+	while (line->next != NULL)
+		line = line->next;
+
+	return line;
+}
+
+LineT* line_append_bytes(LineT* tail, char* data, size_t size, int* lines_added) {
+	LineItemT* tail_item = NULL;
+
+	if (tail != NULL && tail->item_head != NULL) {
+		tail_item = line_item_find_tail(tail->item_head);
+		line_touch(tail);
+	}
+
+	for (size_t i = 0; i < size; i++) {
+		if (tail == NULL || (tail_item != NULL && tail_item->symbol == '\n')) {
+			LineT* line = line_new(NULL);
+
+			if (tail != NULL) {
+				tail->next = line;
+				line->prev = tail;
+			}
+
+			tail = line;
+			tail_item = NULL;
+			(*lines_added)++;
+		}
+
+		LineItemT* item = line_item_new(data[i]);
+
+		if (tail_item == NULL) {
+			tail->item_head = item;
+		} else {
+			tail_item->next = item;
+			item->prev = tail_item;
+		}
+
+		tail_item = item;
+	}
+
+	return tail;
+}
+
+static void line_free_list_from(LineT* line) {
+	while (line != NULL) {
+		LineT* next = line->next;
+
+		line->next = NULL;
+		line_free(line);
+
+		line = next;
+	}
+}
+
+LineT* line_splice_changed(LineT* old_head, LineT* new_head, int* first_changed, int* removed, int* added) {
+	int old_count = line_count_from(old_head);
+	int new_count = line_count_from(new_head);
+	int prefix = 0;
+	int suffix = 0;
+
+	LineT* old_line = old_head;
+	LineT* new_line = new_head;
+	LineT* old_before = NULL;
+
+	while (old_line != NULL && new_line != NULL && line_equal(old_line, new_line)) {
+		old_before = old_line;
+		old_line = old_line->next;
+		new_line = new_line->next;
+		prefix++;
+	}
+
+	LineT* old_after = old_head == NULL ? NULL : line_find_tail(old_head);
+	LineT* new_after = new_head == NULL ? NULL : line_find_tail(new_head);
+
+	while (suffix < old_count - prefix && suffix < new_count - prefix &&
+			line_equal(old_after, new_after)) {
+		old_after = old_after->prev;
+		new_after = new_after->prev;
+		suffix++;
+	}
+
+	old_after = suffix == 0 ? NULL : (old_after == NULL ? old_head : old_after->next);
+	new_after = suffix == 0 ? NULL : (new_after == NULL ? new_head : new_after->next);
+
+	LineT* new_first = prefix < new_count - suffix ? new_line : NULL;
+	LineT* new_last = new_first == NULL ? NULL : (new_after == NULL ? line_find_tail(new_head) : new_after->prev);
+
+	LineT* old_first = old_before == NULL ? old_head : old_before->next;
+
+	if (old_first != old_after) {
+		if (old_after != NULL)
+			old_after->prev->next = NULL;
+
+		line_free_list_from(old_first);
+	}
+
+	if (new_after != NULL && new_after->prev != NULL) {
+		new_after->prev->next = NULL;
+		new_after->prev = NULL;
+	}
+
+	if (new_first != NULL && new_first->prev != NULL) {
+		new_first->prev->next = NULL;
+		new_first->prev = NULL;
+	}
+
+	if (prefix > 0)
+		line_free_list_from(new_head);
+
+	line_free_list_from(new_after);
+
+	LineT* head = prefix > 0 ? old_head : NULL;
+	LineT* tail = old_before;
+
+	if (new_first != NULL) {
+		new_first->prev = tail;
+
+		if (tail == NULL)
+			head = new_first;
+		else
+			tail->next = new_first;
+
+		tail = new_last;
+	}
+
+	if (old_after != NULL) {
+		old_after->prev = tail;
+
+		if (tail == NULL)
+			head = old_after;
+		else
+			tail->next = old_after;
+	} else if (tail != NULL) {
+		tail->next = NULL;
+	}
+
+	*first_changed = prefix;
+	*removed = old_count - prefix - suffix;
+	*added = new_count - prefix - suffix;
+
+	return head;
+}
@@ -208,6 +208,214 @@ int test_line_copy_lines_from() {
 	return 0;
 }
 
+int test_line_serialize_lines_from() {
+	LineT* line_a = line_new_from_str("abc\n");
+	LineT* line_a_2 = line_new_from_str("\tdef\n");
+	LineT* line_a_3 = line_new_from_str("ghi");
+
+	line_add_next(line_a, line_a_2);
+	line_add_next(line_a_2, line_a_3);
+
+	size_t size = 0;
+	char* data = line_serialize_lines_from(line_a, &size);
+
+	int result = 0;
+
+	if (size != strlen("abc\n\tdef\nghi") || strcmp("abc\n\tdef\nghi", data)) {
+		printf("FAIL: test_line_serialize_lines_from, expected 'abc\\n\\tdef\\nghi', got: %s (size %zu)\n", data, size);
+		result = 1;
+	}
+
+	line_free(line_a);
+	free(data);
+
+	return result;
+}
+
+int test_line_hash() {
+	LineT* line_a = line_new_from_str("abc\n");
+	LineT* line_b = line_new_from_str("abc\n");
+	LineT* line_c = line_new_from_str("abd\n");
+
+	int result = 0;
+
+	if (line_hash(line_a) != line_hash(line_b)) {
+		printf("FAIL: test_line_hash, equal lines have different hashes\n");
+		result = 1;
+	}
+
+	if (line_hash(line_a) == line_hash(line_c)) {
+		printf("FAIL: test_line_hash, different lines have equal hashes\n");
+		result = 1;
+	}
+
+	line_c->item_head->next->next->symbol = 'c';
+
+	if (line_hash(line_a) == line_hash(line_c)) {
+		printf("FAIL: test_line_hash, expected cached hash until line_touch\n");
+		result = 1;
+	}
+
+	line_touch(line_c);
+
+	if (line_hash(line_a) != line_hash(line_c)) {
+		printf("FAIL: test_line_hash, expected updated hash after line_touch\n");
+		result = 1;
+	}
+
+	line_add_next(line_a, line_b);
+
+	if (line_hash_lines_from(line_a) == line_hash_lines_from(line_b)) {
+		printf("FAIL: test_line_hash, expected lines hash to cover every line\n");
+		result = 1;
+	}
+
+	line_free(line_a);
+	line_free(line_c);
+
+	return result;
+}
+
+int test_line_version() {
+	LineT* line_a = line_new_from_str("abc\n");
+	LineT* line_b = line_new_from_str("abc\n");
+	uint32_t version = line_a->version;
+
+	int result = 0;
+
+	if (line_a->id == line_b->id) {
+		printf("FAIL: test_line_version, expected unique line ids\n");
+		result = 1;
+	}
+
+	line_touch(line_a);
+
+	if (line_a->version == version) {
+		printf("FAIL: test_line_version, expected line_touch to bump the version\n");
+		result = 1;
+	}
+
+	line_free(line_a);
+	line_free(line_b);
+
+	return result;
+}
+
+LineT* lines_from_str(char* str) {
+	int lines_added = 0;
+	LineT* tail = line_append_bytes(NULL, str, strlen(str), &lines_added);
+
+	return line_find_top(tail);
+}
+
+int test_line_append_bytes() {
+	LineT* head = lines_from_str("ab\ncd");
+	int lines_added = 0;
+
+	line_append_bytes(line_find_tail(head), "e\nf\n", 4, &lines_added);
+
+	size_t size = 0;
+	char* data = line_serialize_lines_from(head, &size);
+
+	int result = 0;
+
+	if (strcmp("ab\ncde\nf\n", data) || line_count_from(head) != 3 || lines_added != 1) {
+		printf("FAIL: test_line_append_bytes, expected 'ab\\ncde\\nf\\n' in 3 lines, got: %s in %d lines\n",
+			data,
+			line_count_from(head));
+		result = 1;
+	}
+
+	line_free(head);
+	free(data);
+
+	return result;
+}
+
+int test_line_splice_changed_case(char* old_str, char* new_str, int expected_first_changed, int expected_removed, int expected_added, bool tail_kept) {
+	LineT* old_head = lines_from_str(old_str);
+	LineT* new_head = lines_from_str(new_str);
+	LineT* old_tail = line_find_tail(old_head);
+	LineT* old_top = old_head;
+
+	int first_changed, removed, added;
+	LineT* head = line_splice_changed(old_head, new_head, &first_changed, &removed, &added);
+
+	size_t size = 0;
+	char* data = line_serialize_lines_from(head, &size);
+
+	int result = 0;
+
+	if (strcmp(new_str, data)) {
+		printf("FAIL: test_line_splice_changed, expected '%s', got: '%s'\n", new_str, data);
+		result = 1;
+	}
+
+	if (first_changed != expected_first_changed || removed != expected_removed || added != expected_added) {
+		printf("FAIL: test_line_splice_changed, '%s' -> '%s' expected changes (%d, -%d, +%d), got: (%d, -%d, +%d)\n",
+			old_str, new_str,
+			expected_first_changed, expected_removed, expected_added,
+			first_changed, removed, added);
+		result = 1;
+	}
+
+	if (expected_first_changed > 0 && head != old_top) {
+		printf("FAIL: test_line_splice_changed, expected unchanged head line to be kept\n");
+		result = 1;
+	}
+
+	if (tail_kept && line_find_tail(head) != old_tail) {
+		printf("FAIL: test_line_splice_changed, expected unchanged tail line to be kept\n");
+		result = 1;
+	}
+
+	line_free(head);
+	free(data);
+
+	return result;
+}
+
+int test_line_splice_changed() {
+	int result = 0;
+
+	result |= test_line_splice_changed_case("a\nb\nc\nd\n", "a\nX\nY\nd\n", 1, 2, 2, true);
+	result |= test_line_splice_changed_case("a\nb\nc\nd\n", "a\nd\n", 1, 2, 0, true);
+	result |= test_line_splice_changed_case("a\nd\n", "a\nb\nc\nd\n", 1, 0, 2, true);
+	result |= test_line_splice_changed_case("a\nb\n", "X\nb\n", 0, 1, 1, true);
+	result |= test_line_splice_changed_case("a\nb\n", "a\nb\nc\n", 2, 0, 1, false);
+	result |= test_line_splice_changed_case("a\nb\n", "a\nb\n", 2, 0, 0, true);
+	result |= test_line_splice_changed_case("a\nb\n", "c\n", 0, 2, 1, false);
+
+	return result;
+}
+
+int test_line_splice_changed_hash_collision() {
+	LineT* old_head = lines_from_str("a\nb\nc\n");
+	LineT* new_head = lines_from_str("a\nX\nc\n");
+
+	new_head->next->hash = line_hash(old_head->next);
+	new_head->next->hash_valid = true;
+
+	int first_changed, removed, added;
+	LineT* head = line_splice_changed(old_head, new_head, &first_changed, &removed, &added);
+
+	size_t size = 0;
+	char* data = line_serialize_lines_from(head, &size);
+
+	int result = 0;
+
+	if (strcmp("a\nX\nc\n", data) || first_changed != 1 || removed != 1 || added != 1) {
+		printf("FAIL: test_line_splice_changed_hash_collision, expected 'a\\nX\\nc\\n' (1, -1, +1), got: '%s' (%d, -%d, +%d)\n",
+			data, first_changed, removed, added);
+		result = 1;
+	}
+
+	line_free(head);
+	free(data);
+
+	return result;
+}
+
 bool run_tests(int n, ...) {
 	va_list args;
 	va_start(args, n);
@@ -224,11 +432,17 @@ bool run_tests(int n, ...) {
 }
 
 int main() {
-	bool test_failed = run_tests(4,
+	bool test_failed = run_tests(10,
 		test_line_to_str,
 		test_line_from_str,
 		test_line_copy,
-		test_line_copy_lines_from
+		test_line_copy_lines_from,
+		test_line_serialize_lines_from,
+		test_line_hash,
+		test_line_version,
+		test_line_append_bytes,
+		test_line_splice_changed,
+		test_line_splice_changed_hash_collision
 	);
 
 	if (test_failed)
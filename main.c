@@ -7,12 +7,24 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
 
 #include "line.c"
 #include "view.h"
 #include "calc.h"
 #include "terminal.c"
+#include "syntax.c"
+#include "render_cache.c"
+#include "wrap_cache.c"
+#include "io.c"
+#include "journal.c"
+#include "watch.c"
+#include "stream.c"
+#include "hex.c"
 
 #define MAX_COMMANDS_BUFFER_SIZE 5
 #define MAX_COMMAND_SIZE 4096
@@ -20,6 +32,8 @@
 #define STATUS_COLUMN_WIDTH 5
 #define INFO_LINE_HEIGHT 1
 #define COMMAND_LINE_HEIGHT 1
+#define STREAM_CHUNKS_PER_FRAME 16
+#define BACKGROUND_FRAME_INTERVAL_MS 33
 
 typedef enum {
 	MODE_NORMAL,
@@ -33,15 +47,27 @@ typedef enum {
 	INFO_LINE,
 	HIGHLIGHT,
 	WHITE,
+	CODE,
+	CODE_KEYWORD,
+	CODE_TYPE,
+	CODE_STRING,
+	CODE_NUMBER,
+	CODE_COMMENT,
+	CODE_PREPROC,
 } Color;
 
 typedef enum {
 	EC_MOVE_CURSOR,
 	EC_NORMALIZE_CURSOR,
 	EC_SCROLL,
+	EC_SCROLL_HORIZONTAL,
 	EC_INSERT,
 	EC_SWITCH_WINDOW,
 	EC_SAVE_FILE,
+	EC_FOLLOW,
+	EC_GOTO,
+	EC_SWITCH_BUFFER,
+	EC_SAVE_ALL,
 	EC_QUIT,
 } EditorCommandType;
 
@@ -62,6 +88,10 @@ typedef enum {
 	UC_G,
 	UC_CTRL_d,
 	UC_CTRL_u,
+	UC_zl,
+	UC_zh,
+	UC_zs,
+	UC_ze,
 	UC_esc,
 	UC_colon,
 	UC_i,
@@ -75,18 +105,50 @@ typedef enum {
 	UC_CTRL_w_k,
 	UC_QUIT,
 	UC_SAVE_FILE,
+	UC_FOLLOW,
+	UC_SET_WRAP,
+	UC_SET_NOWRAP,
+	UC_GOTO,
+	UC_BUFFER_NEXT,
+	UC_BUFFER_PREV,
+	UC_SAVE_ALL,
 } UserCommandType;
 
 
 typedef struct {
 	int scroll;
+	bool hex;
+	int max_fps;
+	bool frame_per_key;
+	bool wrap;
 } EditorConfig;
 
+typedef struct {
+	uint64_t rendered;
+	uint64_t skipped;
+	uint64_t render_ns;
+	uint64_t resizes;
+	uint64_t resize_ns_last;
+	uint64_t resize_ns_max;
+} EditorFrameStats;
+
+typedef struct {
+	ViewT* main_view;
+	ViewT* source_view;
+	ViewT* editor_tab_view;
+	ViewT* command_line_view;
+	ViewT* debug_info_view;
+} EditorLayoutT;
+
 typedef struct {
 	char symbol;
 	bool append;
 } UserCommandDataSymbol;
 
+typedef struct {
+	uint64_t offset;
+} UserCommandDataOffset;
+
 typedef struct {
 	UserCommandType type;
 	int count;
@@ -156,22 +218,106 @@ typedef enum {
 	ED_SCROLL_UP,
 } EditorScrollDirection;
 
+typedef enum {
+	ED_SCROLL_RIGHT,
+	ED_SCROLL_LEFT,
+	ED_SCROLL_CURSOR_START,
+	ED_SCROLL_CURSOR_END,
+} EditorScrollHorizontalDirection;
+
 typedef struct {
 	EditorScrollDirection direction;
 	int scroll;
 } EditorCommandScrollData;
 
+typedef struct {
+	EditorScrollHorizontalDirection direction;
+	int scroll;
+} EditorCommandScrollHorizontalData;
+
+typedef struct {
+	uint64_t offset;
+} EditorCommandGotoData;
+
+typedef struct {
+	int direction;
+} EditorCommandSwitchBufferData;
+
 typedef struct {
 	EditorCommandType type;
 	char data[256];
 } EditorCommand;
 
+typedef struct {
+	LineT* head_line;
+	bool compressed;
+	off_t size;
+	uint64_t hash;
+	struct timespec mtime;
+	dev_t dev;
+	ino_t ino;
+} SourceFileT;
+
 typedef struct EditorBuffer {
 	LineT* head_line;
+	LineT* tail_line;
+	int lines_count;
 	char* filename;
+	bool compressed;
+	bool modified;
+	uint64_t version;
+	uint64_t saved_hash;
+	bool saved_hash_valid;
+	off_t saved_size;
+	uint64_t saved_bytes_hash;
+	struct timespec saved_mtime;
+	dev_t saved_dev;
+	ino_t saved_ino;
+	struct timespec warned_mtime;
+	int writes_in_flight;
+	int watch_wd;
+	bool disk_changed;
+	bool follow;
+	JournalT* journal;
+	StreamT* stream;
+	uint64_t stream_bytes;
+	HexT* hex;
+	SyntaxT* syntax;
+	uint32_t syntax_epoch;
+	bool loading;
+	bool journal_pending;
+	int journal_index;
 	struct EditorBuffer* next;
 } EditorBufferT;
 
+typedef struct {
+	uint64_t generation;
+	int x;
+	int y;
+	int rows;
+	int cols;
+	int y_offset;
+	int cursor_y;
+	int lines_count;
+	void* buffer;
+	uint64_t version;
+	int wrap_width;
+	int top_line_row;
+} EditorStatusColumnState;
+
+typedef struct {
+	uint64_t generation;
+	int x;
+	int y;
+	int rows;
+	int cols;
+	char* filename;
+	bool modified;
+	int text_end;
+	int position_start;
+	char position[64];
+} EditorInfoLineState;
+
 typedef struct {
 	EditorBufferT* editor_buffer;
 	LineItemT* cursor_line_item;
@@ -182,6 +328,13 @@ typedef struct {
 	Pos cursor_pos;
 	int x_offset;
 	int y_offset;
+	uint64_t top_line_id;
+	int top_line_row;
+	bool pinned;
+	int hex_nibble;
+	int drawn_y_offset;
+	EditorStatusColumnState drawn_status_column;
+	EditorInfoLineState drawn_info_line;
 } EditorWindow;
 
 typedef struct EditorTabItem {
@@ -206,6 +359,13 @@ typedef struct {
 	int* cols;
 } DebugInformation;
 
+typedef struct {
+	int pending;
+	int count;
+	int failed;
+	int64_t started_ms;
+} IoBatchT;
+
 bool exit_loop = false;
 
 const char conf_non_word_symbols[] = {
@@ -223,6 +383,7 @@ const char* conf_normal_mode_valid_commands[] = {
 	"G", "gg",
 	"\x04", // CTRL-d
 	"\x15", // CTRL-u
+	"zl", "zh", "zs", "ze",
 	"\x1b", // CTRL-[
 	":",
 	"i", "a", "I", "A",
@@ -237,16 +398,33 @@ const char* conf_normal_mode_valid_commands[] = {
 const char* conf_command_mode_valid_commands[] = {
 	"q", "quit",
 	"w", "wq",
+	"follow",
+	"wa", "bn", "bnext", "bp", "bprevious",
+	"set wrap", "set nowrap",
 
 	"-1",
 };
 
-terminal_color terminal_color_cursor = "\033[90;107m";
-terminal_color terminal_color_clear = "\033[0m";
-terminal_color terminal_color_highlight = "\033[48;5;240m";
-terminal_color terminal_color_info_line = "\033[30;47m";
+terminal_color editor_palette[] = {
+	[CLEAR] = "\033[0m",
+	[CURSOR] = "\033[0;90;107m",
+	[INFO_LINE] = "\033[0;30;47m",
+	[HIGHLIGHT] = "\033[0;48;5;240m",
+	[WHITE] = "\033[0m",
+	[CODE] = "\033[0m",
+	[CODE_KEYWORD] = "\033[0;33m",
+	[CODE_TYPE] = "\033[0;32m",
+	[CODE_STRING] = "\033[0;31m",
+	[CODE_NUMBER] = "\033[0;35m",
+	[CODE_COMMENT] = "\033[0;36m",
+	[CODE_PREPROC] = "\033[0;34m",
+};
 
 EditorBufferT* buffers;
+EditorBufferT* streaming_buffer = NULL;
+EditorBufferT* journal_prompt_buffer = NULL;
+IoBatchT load_batch = {};
+IoBatchT save_batch = {};
 EditorTabT* current_editor_tab;
 int64_t tabno_counter = 0;
 
@@ -255,7 +433,8 @@ ModeType mode_type;
 UserCommand user_commands[MAX_COMMANDS_BUFFER_SIZE] = {};
 EditorCommand editor_commands[MAX_COMMANDS_BUFFER_SIZE] = {};
 
-EditorConfig editor_config = {.scroll = 1};
+EditorConfig editor_config = {.scroll = 1, .hex = false, .max_fps = 0, .frame_per_key = false, .wrap = false};
+EditorFrameStats editor_frame_stats = {};
 
 NormalModeCommand normal_mode_command = {.count = 0, .command = ""};
 CommandModeCommand command_mode_command = {.command = ""};
@@ -274,6 +453,10 @@ void editor_config_set_scroll(int scroll) {
 	editor_config.scroll = scroll;
 }
 
+void editor_config_set_wrap(bool wrap) {
+	editor_config.wrap = wrap;
+}
+
 void message_set(char* message) {
 	sprintf(message_line_data.message, "%s", message);
 }
@@ -320,13 +503,44 @@ char* symbol_to_printable(char symbol) {
 	return printable;
 }
 
+const char format_digit_pairs[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+int format_int(char* text, int value) {
+	char digits[16];
+	unsigned int rest = value < 0 ? 0 : value;
+	int length = 0;
+
+	while (rest >= 100) {
+		int pair = (rest % 100) * 2;
+
+		rest /= 100;
+		digits[length++] = format_digit_pairs[pair + 1];
+		digits[length++] = format_digit_pairs[pair];
+	}
+
+	if (rest >= 10) {
+		digits[length++] = format_digit_pairs[rest * 2 + 1];
+		digits[length++] = format_digit_pairs[rest * 2];
+	} else {
+		digits[length++] = '0' + rest;
+	}
+
+	for (int i = 0; i < length; i++)
+		text[i] = digits[length - 1 - i];
+
+	text[length] = 0;
+
+	return length;
+}
+
 char* string_to_printable(char* str) {
 	char* printable = (char*)malloc(sizeof(char) * strlen(str) * strlen("<non-printable>") + 1);
+	printable[0] = 0;
 
 	for (int i = 0; i < strlen(str); i++) {
 		char* p = symbol_to_printable(str[i]);
 
-		sprintf(printable, "%s%s", printable, p);
+		strcat(printable, p);
 
 		free(p);
 	}
@@ -336,6 +550,35 @@ char* string_to_printable(char* str) {
 
 EditorBufferT* editor_buffer_new() {
 	EditorBufferT* buffer = (EditorBufferT*)malloc(sizeof(EditorBufferT));
+	buffer->head_line = NULL;
+	buffer->tail_line = NULL;
+	buffer->lines_count = 0;
+	buffer->filename = "";
+	buffer->compressed = false;
+	buffer->modified = false;
+	buffer->version = 0;
+	buffer->saved_hash = 0;
+	buffer->saved_hash_valid = false;
+	buffer->saved_size = -1;
+	buffer->saved_bytes_hash = LINE_HASH_OFFSET;
+	buffer->saved_dev = 0;
+	buffer->saved_ino = 0;
+	buffer->warned_mtime.tv_sec = 0;
+	buffer->warned_mtime.tv_nsec = 0;
+	buffer->writes_in_flight = 0;
+	buffer->watch_wd = -1;
+	buffer->disk_changed = false;
+	buffer->follow = false;
+	buffer->journal = NULL;
+	buffer->stream = NULL;
+	buffer->stream_bytes = 0;
+	buffer->hex = NULL;
+	buffer->syntax = NULL;
+	buffer->syntax_epoch = 1;
+	buffer->loading = false;
+	buffer->journal_pending = false;
+	buffer->journal_index = 0;
+	buffer->next = NULL;
 
 	if (buffers == NULL) {
 		buffers = buffer;
@@ -357,19 +600,134 @@ EditorBufferT* editor_buffer_find_by_filename(char* filename) {
 
 	EditorBufferT* editor_buffer = buffers;
 
-	while (strcmp(filename, editor_buffer->filename)) {
+	while (editor_buffer != NULL && strcmp(filename, editor_buffer->filename)) {
 		editor_buffer = editor_buffer->next;
 	}
 
 	return editor_buffer;
 }
 
+char* editor_buffer_name(EditorBufferT* buffer) {
+	if (buffer->stream != NULL || buffer->stream_bytes > 0)
+		return "[stdin]";
+
+	return buffer->filename;
+}
+
+void editor_buffer_set_lines(EditorBufferT* buffer, LineT* head_line) {
+	buffer->head_line = head_line;
+	buffer->tail_line = head_line;
+	buffer->lines_count = 1;
+
+	while (buffer->tail_line->next != NULL) {
+		buffer->tail_line = buffer->tail_line->next;
+		buffer->lines_count++;
+	}
+}
+
+int editor_buffer_append_bytes(EditorBufferT* buffer, char* data, size_t size) {
+	int lines_added = 0;
+
+	buffer->tail_line = line_append_bytes(buffer->tail_line, data, size, &lines_added);
+	buffer->lines_count += lines_added;
+	buffer->version++;
+
+	return lines_added;
+}
+
+void editor_buffer_touch(EditorBufferT* buffer, LineT* line) {
+	if (line != NULL)
+		line_touch(line);
+
+	buffer->modified = true;
+	buffer->version++;
+}
+
+void editor_buffer_stat_disk(EditorBufferT* buffer, off_t* size, struct timespec* mtime) {
+	struct stat st;
+
+	if (stat(buffer->filename, &st) < 0) {
+		*size = -1;
+		mtime->tv_sec = 0;
+		mtime->tv_nsec = 0;
+
+		return;
+	}
+
+	*size = st.st_size;
+	*mtime = st.st_mtim;
+}
+
+void editor_buffer_mark_loaded(EditorBufferT* buffer) {
+	buffer->saved_hash_valid = false;
+	editor_buffer_stat_disk(buffer, &buffer->saved_size, &buffer->saved_mtime);
+}
+
+void editor_buffer_mark_source(EditorBufferT* buffer, SourceFileT* source) {
+	buffer->saved_size = source->size;
+	buffer->saved_bytes_hash = source->hash;
+	buffer->saved_mtime = source->mtime;
+	buffer->saved_dev = source->dev;
+	buffer->saved_ino = source->ino;
+}
+
+void editor_buffer_mark_saved(EditorBufferT* buffer, uint64_t hash, uint64_t bytes_hash) {
+	SourceFileT source = {.size = -1, .hash = bytes_hash};
+	struct stat st;
+
+	if (stat(buffer->filename, &st) == 0) {
+		source.size = st.st_size;
+		source.mtime = st.st_mtim;
+		source.dev = st.st_dev;
+		source.ino = st.st_ino;
+	}
+
+	buffer->saved_hash = hash;
+	buffer->saved_hash_valid = true;
+	editor_buffer_mark_source(buffer, &source);
+}
+
+void editor_buffer_prepare_edit(EditorBufferT* buffer) {
+	if (buffer->modified || buffer->saved_hash_valid)
+		return;
+
+	buffer->saved_hash = line_hash_lines_from(buffer->head_line);
+	buffer->saved_hash_valid = true;
+}
+
+bool editor_buffer_disk_unchanged(EditorBufferT* buffer) {
+	off_t size;
+	struct timespec mtime;
+
+	editor_buffer_stat_disk(buffer, &size, &mtime);
+
+	return size >= 0 && size == buffer->saved_size &&
+		mtime.tv_sec == buffer->saved_mtime.tv_sec &&
+		mtime.tv_nsec == buffer->saved_mtime.tv_nsec;
+}
+
+JournalHeader editor_buffer_journal_header(EditorBufferT* buffer) {
+	JournalHeader header = {
+		.source_size = buffer->saved_size,
+		.source_mtime_sec = buffer->saved_mtime.tv_sec,
+		.source_mtime_nsec = buffer->saved_mtime.tv_nsec,
+	};
+
+	return header;
+}
+
 EditorWindow* editor_window_new() {
 	return (EditorWindow*)malloc(sizeof(EditorWindow));
 }
 
 EditorTabItemT* editor_tab_item_new() {
-	return (EditorTabItemT*)malloc(sizeof(EditorTabItemT));
+	EditorTabItemT* editor_tab_item = (EditorTabItemT*)malloc(sizeof(EditorTabItemT));
+	editor_tab_item->right = NULL;
+	editor_tab_item->left = NULL;
+	editor_tab_item->down = NULL;
+	editor_tab_item->up = NULL;
+
+	return editor_tab_item;
 }
 
 EditorTabT* editor_tab_new() {
@@ -390,334 +748,778 @@ void pos_copy(Pos* to, Pos* from) {
 }
 
 
-void s_exit_editor() {
-	exit_loop = true;
-}
+int64_t clock_ms() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
 
-terminal_color* color_to_terminal_color(Color color) {
-	switch (color) {
-		case CURSOR:
-			return &terminal_color_cursor;
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
 
-		case INFO_LINE:
-			return &terminal_color_info_line;
+int64_t clock_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
 
-		case HIGHLIGHT:
-			return &terminal_color_highlight;
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
 
-		case WHITE:
-			return &terminal_color_clear;
+void io_batch_add(IoBatchT* batch, IoJobT* job) {
+	if (batch == NULL)
+		return;
 
-		case CLEAR:
-			return &terminal_color_clear;
+	if (batch->pending == 0) {
+		batch->count = 0;
+		batch->failed = 0;
+		batch->started_ms = clock_ms();
 	}
 
-	return &terminal_color_clear;
+	batch->pending++;
+	batch->count++;
+	job->batch = batch;
 }
 
-void r_draw_line(int x, int y, int max_len, char* text, Color color) {
-	int text_len = strlen(text);
+void io_batch_finish(IoBatchT* batch, bool failed, char* verb) {
+	if (batch == NULL)
+		return;
+
+	batch->pending--;
 
-	for (int i = 0; i < max_len; i++) {
-		char symbol = ' ';
-		if (i < text_len)
-			symbol = text[i];
+	if (failed)
+		batch->failed++;
 
-		current_grid[y][x + i].symbol = symbol;
-		current_grid[y][x + i].color = color_to_terminal_color(color);
+	if (batch->pending > 0 || (batch->count == 1 && batch->failed == 0))
+		return;
+
+	char message[MAX_MESSAGE_SIZE] = {0};
+
+	if (batch->failed > 0) {
+		snprintf(message, MAX_MESSAGE_SIZE, "E: %d of %d files failed, rest %s in %ldms",
+			batch->failed,
+			batch->count,
+			verb,
+			(long)(clock_ms() - batch->started_ms));
+	} else {
+		snprintf(message, MAX_MESSAGE_SIZE, "%d files %s in %ldms on %d workers",
+			batch->count,
+			verb,
+			(long)(clock_ms() - batch->started_ms),
+			io_workers());
 	}
-}
 
-int b_read_input(void *buf) {
-	return read(STDIN_FILENO, buf, sizeof(buf));
+	message_set(message);
 }
 
-void switch_grids() {
-	memcpy(
-		rendered_grid,
-		current_grid,
-		sizeof(current_grid)
-	);
+void s_exit_editor() {
+	exit_loop = true;
 }
 
-LineT* read_and_parse_source_file(char *file_name) {
-	int y = 0;
-	char line[256];
-	FILE *source_file = fopen(file_name, "r");
+int resize_notify_pipe[2] = {-1, -1};
 
-	LineT* head_line = NULL;
-	LineT* current_line = head_line;
-	LineT* prev_line = NULL;
+void s_resize_editor() {
+	int saved_errno = errno;
+	int64_t signaled_ns = clock_ns();
 
-	while (fgets(line, 256, source_file)) {
-		current_line = line_new_from_str(line);
-		if (head_line == NULL)
-			head_line = current_line;
+	write(resize_notify_pipe[1], &signaled_ns, sizeof(signaled_ns));
 
-		if (prev_line != NULL) {
-			prev_line->next = current_line;
-			current_line->prev = prev_line;
-		}
+	errno = saved_errno;
+}
 
-		prev_line = current_line;
+void resize_start() {
+	pipe(resize_notify_pipe);
+
+	for (int i = 0; i < 2; i++) {
+		fcntl(resize_notify_pipe[i], F_SETFL, O_NONBLOCK);
+		fcntl(resize_notify_pipe[i], F_SETFD, FD_CLOEXEC);
 	}
 
-	fclose(source_file);
+	signal(SIGWINCH, s_resize_editor);
+}
+
+int64_t resize_drain() {
+	int64_t signaled_ns = 0;
+	int64_t first_ns = 0;
+
+	while (read(resize_notify_pipe[0], &signaled_ns, sizeof(signaled_ns)) == sizeof(signaled_ns)) {
+		if (first_ns == 0)
+			first_ns = signaled_ns;
+	}
 
-	return head_line;
+	return first_ns;
 }
 
-void write_buffer_into_file(EditorBufferT* buffer) {
-	assert(strcmp("", buffer->filename));
+void r_draw_line(int x, int y, int max_len, char* text, Color color) {
+	TerminalRow row = t_row(x, y);
+	int i = 0;
 
-	FILE *source_file = fopen(buffer->filename, "w");
+	for (; i < max_len && text[i] != 0; i++)
+		t_row_set(&row, i, text[i], color);
 
-	LineT* current_line = buffer->head_line;
+	for (; i < max_len; i++)
+		t_row_set(&row, i, ' ', color);
+}
 
-	while (current_line != NULL) {
-		char* line_str = line_to_str(current_line);
+int b_read_input(void *buf, size_t size) {
+	return read(t_input_fd, buf, size);
+}
 
-		fprintf(source_file, "%s", line_str);
+bool b_input_eof = false;
 
-		free(line_str);
+bool b_input_pending() {
+	struct pollfd poll_fd = {.fd = t_input_fd, .events = POLLIN};
 
-		current_line = current_line->next;
-	}
+	return poll(&poll_fd, 1, 0) > 0 && (poll_fd.revents & (POLLIN | POLLHUP | POLLERR));
+}
 
-	fclose(source_file);
+void switch_grids() {
+	t_switch_grids();
 }
 
-void draw_editor_window_source(EditorWindow* window) {
-	ViewT* view = window->source_view;
-	int y_offset = window->y_offset;
-	LineT* cursor_line = window->cursor_line;
+bool file_is_gzip(int fd) {
+	unsigned char magic[2];
 
-	int view_cols_count = view_cols(view);
-	int view_rows_count = view_rows(view);
+	return pread(fd, magic, 2, 0) == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+}
 
-	int source_file_skip_lines = y_offset;
+bool filename_is_gzip(char* file_name) {
+	size_t len = strlen(file_name);
 
-	LineT* source_file_line = window->editor_buffer->head_line;
+	return len > 3 && !strcmp(file_name + len - 3, ".gz");
+}
 
-	while (source_file_skip_lines > 0) {
-		assert(source_file_line != NULL);
+// size is the number of bytes actually consumed from the file and mtime comes
+// from the same fd before reading, so bytes appended while loading are picked
+// up by the next disk check instead of being skipped or read twice.
+LineT* read_source_file(char* file_name, SourceFileT* source) {
+	char chunk[IO_CHUNK_SIZE];
+	int fd = open(file_name, O_RDONLY);
 
-		source_file_line = source_file_line->next;
-		source_file_skip_lines--;
-	}
+	LineT* tail_line = NULL;
+	int lines_count = 0;
 
-	for (int y = 0; y < view_rows_count; y++) {
-		bool line_ended = false;
+	source->compressed = filename_is_gzip(file_name);
+	source->size = -1;
+	source->hash = LINE_HASH_OFFSET;
+	source->mtime = (struct timespec){};
+	source->dev = 0;
+	source->ino = 0;
 
-		LineItemT* source_file_line_item;
+	if (fd >= 0) {
+		struct stat st;
+		fstat(fd, &st);
 
-		if (source_file_line != NULL) {
-			 source_file_line_item = source_file_line->item_head;
-		}
+		source->compressed = file_is_gzip(fd);
+		source->mtime = st.st_mtim;
+		source->dev = st.st_dev;
+		source->ino = st.st_ino;
 
-		for (int x = 0; x < view_cols_count; x++) {
-			if (source_file_line_item == NULL)
-				line_ended = true;
+		if (source->compressed) {
+			gzFile source_file = gzdopen(fd, "rb");
+			gzbuffer(source_file, IO_CHUNK_SIZE);
 
-			if (line_ended) {
-				Cell cell = {.symbol = ' ', .color = &terminal_color_clear};
+			int n;
 
-				memcpy(&current_grid[view_y(view, y)][view_x(view, x)], &cell, sizeof(Cell));
+			while ((n = gzread(source_file, chunk, sizeof(chunk))) > 0)
+				tail_line = line_append_bytes(tail_line, chunk, n, &lines_count);
 
-				continue;
+			gzclose(source_file);
+
+			source->size = st.st_size;
+		} else {
+			ssize_t n;
+
+			source->size = 0;
+
+			while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+				tail_line = line_append_bytes(tail_line, chunk, n, &lines_count);
+				source->hash = line_hash_bytes(source->hash, chunk, n);
+				source->size += n;
 			}
 
-			if (source_file_line_item->symbol == '\t') {
-				for (int j = 0; j < 4 && x + j < view_cols_count; j++) {
-					Cell cell = {.symbol = ' ', .color = &terminal_color_clear};
+			close(fd);
+		}
+	}
 
-					if (j == 0)
-						cell.symbol = '>';
+	source->head_line = tail_line == NULL ? line_new(line_item_new('\n')) : line_find_top(tail_line);
 
-					memcpy(&current_grid[view_y(view, y)][view_x(view, x + j)], &cell, sizeof(Cell));
-				}
+	return source->head_line;
+}
 
-				x += 3;
+LineT* read_and_parse_source_file(char *file_name, bool* compressed) {
+	SourceFileT source;
 
-				source_file_line_item = source_file_line_item->next;
-			} else {
-				Cell cell = {.symbol = source_file_line_item->symbol, .color = &terminal_color_clear};
+	read_source_file(file_name, &source);
+	*compressed = source.compressed;
 
-				if (line_item_is_newline(source_file_line_item))
-					cell.symbol = '<';
+	return source.head_line;
+}
 
-				memcpy(&current_grid[view_y(view, y)][view_x(view, x)], &cell, sizeof(Cell));
+void write_buffer_into_file(EditorBufferT* buffer, IoBatchT* batch) {
+	if (!strcmp("", buffer->filename)) {
+		message_set("E32: No file name");
 
-				source_file_line_item = source_file_line_item->next;
-			}
-		}
+		return;
+	}
+
+	if (buffer->loading) {
+		char message[MAX_MESSAGE_SIZE] = {0};
+		snprintf(message, MAX_MESSAGE_SIZE, "E: \"%s\" is still loading", buffer->filename);
+		message_set(message);
 
-		if (source_file_line != NULL)
-			source_file_line = source_file_line->next;
+		return;
 	}
-}
 
-void draw_editor_window_status_column(EditorWindow* window) {
-	ViewT* view = window->status_column_view;
-	int y_offset = window->y_offset;
-	int total_rows = line_count_from(window->editor_buffer->head_line);
-	int view_rows_count = view_rows(view);
-	int view_cols_count = view_cols(view);
+	uint64_t hash = buffer->saved_hash;
 
-	for (int y = 0; y < view_rows_count; y++) {
-		char column_text[256] = {0};
+	if (buffer->modified)
+		hash = line_hash_lines_from(buffer->head_line);
 
-		if (y + y_offset + 1 <= total_rows) {
-			sprintf(column_text, "%d", y + y_offset + 1);
-		} else {
-			sprintf(column_text, "");
-		}
+	size_t size = 0;
+	char* data = NULL;
+	bool unchanged = (!buffer->modified || hash == buffer->saved_hash) && editor_buffer_disk_unchanged(buffer);
 
-		Color color = WHITE;
+	// A matching hash alone could be a collision, the save is only skipped
+	// once the file on disk holds exactly the serialized buffer.
+	if (unchanged && buffer->modified) {
+		data = line_serialize_lines_from(buffer->head_line, &size);
+		unchanged = (buffer->compressed || (off_t)size == buffer->saved_size) &&
+			io_file_matches(buffer->filename, buffer->compressed, data, size);
+	}
 
-		if (y == window->cursor_pos.y)
-			color = HIGHLIGHT;
+	if (unchanged) {
+		buffer->modified = false;
+		free(data);
 
-		r_draw_line(view_x(view, 0), view_y(view, y), view_cols_count, column_text, color);
+		char message[MAX_MESSAGE_SIZE] = {0};
+		snprintf(message, MAX_MESSAGE_SIZE, "\"%s\" unchanged, not written", buffer->filename);
+		message_set(message);
+
+		return;
 	}
+
+	if (!buffer->modified && !buffer->saved_hash_valid)
+		hash = line_hash_lines_from(buffer->head_line);
+
+	if (data == NULL)
+		data = line_serialize_lines_from(buffer->head_line, &size);
+
+	buffer->writes_in_flight++;
+
+	IoJobT* job = io_job_new_write(buffer->filename, data, size, buffer);
+	job->compress = buffer->compressed;
+	job->content_hash = hash;
+	job->data_hash = line_hash_bytes(LINE_HASH_OFFSET, data, size);
+	job->version = buffer->version;
+
+	if (buffer->journal != NULL)
+		job->journal_checkpoint = buffer->journal->records_count;
+
+	io_batch_add(batch, job);
+	io_submit(job);
 }
 
-void draw_editor_window_info_line(EditorWindow* window) {
-	ViewT* view = window->info_line_view;
-	char* filename = window->editor_buffer->filename;
-	int line = window->cursor_pos.y + window->y_offset;
-	int column = window->cursor_pos.x + window->x_offset;
-	int view_cols_count = view_cols(view);
-	int view_rows_count = view_rows(view);
+size_t editor_window_hex_offset(EditorWindow* window) {
+	return (size_t)(window->y_offset + window->cursor_pos.y) * HEX_BYTES_PER_ROW + window->cursor_pos.x;
+}
+
+int hex_column_of_byte(int column) {
+	return 10 + column * 3 + (column >= HEX_BYTES_PER_ROW / 2);
+}
+
+int hex_ascii_column_of_byte(int column) {
+	return hex_column_of_byte(HEX_BYTES_PER_ROW) + 2 + column;
+}
+
+void draw_editor_window_hex(EditorWindow* window) {
+	ViewT* view = window->source_view;
+	HexT* hex = window->editor_buffer->hex;
+	int view_cols_count = view_visible_cols(view);
+	int view_rows_count = view_visible_rows(view);
 
 	for (int y = 0; y < view_rows_count; y++) {
-		for (int x = 0; x < view_cols_count; x++) {
-			current_grid[view_y(view, y)][view_x(view, x)].symbol = ' ';
-			current_grid[view_y(view, y)][view_x(view, x)].color = &terminal_color_info_line;
-		}
-	}
+		char text[128] = {0};
+		size_t row_offset = (size_t)(window->y_offset + y) * HEX_BYTES_PER_ROW;
 
-	for (int x = 0; x < strlen(filename) && x < view_cols_count; x++) {
-		current_grid[view_y(view, 0)][view_x(view, x)].symbol = filename[x];
-	}
+		if (row_offset < hex->size) {
+			size_t row_size = MIN(HEX_BYTES_PER_ROW, hex->size - row_offset);
+			uint8_t* row = hex->data + row_offset;
+
+			memset(text, ' ', sizeof(text) - 1);
+			sprintf(text, "%08zx", row_offset);
+			text[8] = ' ';
 
-	char line_and_column_text[256];
+			for (int i = 0; i < row_size; i++) {
+				static const char digits[] = "0123456789abcdef";
+				char ascii = row[i];
 
-	sprintf(line_and_column_text, "%d,%d", line, column);
+				text[hex_column_of_byte(i)] = digits[row[i] >> 4];
+				text[hex_column_of_byte(i) + 1] = digits[row[i] & 0xf];
+				text[hex_ascii_column_of_byte(i)] = symbol_is_printable(ascii) ? ascii : '.';
+			}
 
-	int line_and_column_text_len = strlen(line_and_column_text);
+			text[hex_ascii_column_of_byte(0) - 1] = '|';
+			text[hex_ascii_column_of_byte(row_size)] = '|';
+			text[hex_ascii_column_of_byte(row_size) + 1] = 0;
+		}
 
-	for (int x = 0; x < strlen(line_and_column_text); x++) {
-		current_grid[view_y(view, 0)][view_x(view, view_cols_count - x - 2)].symbol = line_and_column_text[line_and_column_text_len - 1 - x];
+		r_draw_line(view_x(view, 0), view_y(view, y), view_cols_count, text, CLEAR);
 	}
 }
 
-void draw_cursor(EditorWindow* editor_window) {
-	ViewT* view = editor_window->source_view;
-	int x = editor_window->cursor_pos.x;
-	int y = editor_window->cursor_pos.y;
+int editor_window_line_rows(EditorWindow* window, LineT* line) {
+	if (!editor_config.wrap)
+		return 1;
 
-	current_grid[view_y(view, y)][view_x(view, x)].color = &terminal_color_cursor;
+	return wrap_layout(line, view_cols(window->source_view))->rows;
 }
 
-void highlight_line(EditorWindow* editor_window) {
-	int y = editor_window->cursor_pos.y;
-	ViewT* view = editor_window->source_view;
-	int view_cols_count = view_cols(view);
+int editor_window_cursor_wrap_row(EditorWindow* window) {
+	if (!editor_config.wrap)
+		return 0;
 
-	for (int x = 0; x < view_cols_count; x++) {
-		current_grid[view_y(view, y)][view_x(view, x)].color = &terminal_color_highlight;
-	}
+	return wrap_layout_row_of_column(wrap_layout(window->cursor_line, view_cols(window->source_view)), window->cursor_pos.x);
 }
 
-void draw_editor_window(EditorWindow* window) {
-	draw_editor_window_source(window);
-	draw_editor_window_status_column(window);
-	draw_editor_window_info_line(window);
+LineT* editor_window_top_line(EditorWindow* window) {
+	LineT* line = window->cursor_line;
+
+	for (int i = 0; i < window->cursor_pos.y && line->prev != NULL; i++)
+		line = line->prev;
+
+	for (int i = 0; i > window->cursor_pos.y && line->next != NULL; i--)
+		line = line->next;
+
+	return line;
 }
 
-void draw_editor_tab_item(EditorTabT* editor_tab, EditorTabItemT* editor_tab_item) {
-	if (editor_tab_item == NULL)
-		return;
+// Wrap rows of the top line scrolled above the view, only kept while the
+// window's top line is still the line they were set for.
+int editor_window_top_line_row(EditorWindow* window, LineT* top_line) {
+	if (!editor_config.wrap || top_line == NULL || top_line->id != window->top_line_id)
+		return 0;
 
-	draw_editor_window(editor_tab_item->window);
+	return MIN(window->top_line_row, editor_window_line_rows(window, top_line) - 1);
+}
 
-	if (editor_tab_item->tabno == editor_tab->tab_item_current->tabno) {
-		highlight_line(editor_tab_item->window);
-		draw_cursor(editor_tab_item->window);
+int editor_window_cursor_screen_row(EditorWindow* window) {
+	int row = editor_window_cursor_wrap_row(window);
+	LineT* line = window->cursor_line;
+
+	for (int i = 0; i < window->cursor_pos.y && line->prev != NULL; i++) {
+		line = line->prev;
+		row += editor_window_line_rows(window, line);
 	}
 
-	draw_editor_tab_item(editor_tab, editor_tab_item->right);
-	draw_editor_tab_item(editor_tab, editor_tab_item->down);
+	return row - editor_window_top_line_row(window, line);
 }
 
-void draw_editor_tab(EditorTabT* editor_tab) {
-	draw_editor_tab_item(editor_tab, editor_tab->tab_item_head);
-}
+int editor_window_visible_lines(EditorWindow* window, int rows) {
+	if (!editor_config.wrap)
+		return rows;
 
-void draw_command_line(ViewT* view) {
-	int cols = view_cols(view);
-	int y = view_y(view, 0);
+	int count = 0;
+	int used = -editor_window_top_line_row(window, editor_window_top_line(window));
 
-	for (int x = view->origin.x; x < view->end.x; x++) {
-		current_grid[y][x].symbol = ' ';
-		current_grid[y][x].color = &terminal_color_clear;
+	for (LineT* line = editor_window_top_line(window); line != NULL && used < rows; line = line->next) {
+		used += editor_window_line_rows(window, line);
+		count++;
 	}
 
-	if (mode_type == MODE_NORMAL) {
-		for (int i = 0; i < strlen(message_line_data.message); i++) {
-			current_grid[y][i].symbol = message_line_data.message[i];
-		}
-
-		char user_modifier_text[256] = {0};
+	return MAX(1, count);
+}
 
-		if (normal_mode_command.count > 0)
-			sprintf(user_modifier_text, "%d", normal_mode_command.count);
+LineT* draw_editor_window_source_wrapped(EditorWindow* window, LineT* source_file_line, uint8_t* syntax_state) {
+	ViewT* view = window->source_view;
+	SyntaxT* syntax = window->editor_buffer->syntax;
+	int view_cols_count = view_visible_cols(view);
+	int view_rows_count = view_visible_rows(view);
+	int y = 0;
+	int first_row = editor_window_top_line_row(window, source_file_line);
 
-		if (strlen(normal_mode_command.command) > 0) {
-			char* printable_cmd = string_to_printable(normal_mode_command.command);
-			sprintf(user_modifier_text, "%s%s", user_modifier_text, printable_cmd);
+	for (; source_file_line != NULL && y < view_rows_count; source_file_line = source_file_line->next, first_row = 0) {
+		WrapLayoutT* layout = wrap_layout(source_file_line, view_cols(view));
 
-			free(printable_cmd);
-		}
+		*syntax_state = syntax_line_sync(syntax, source_file_line, *syntax_state, window->editor_buffer->syntax_epoch);
 
-		if (strlen(user_modifier_text) == 0)
-			sprintf(user_modifier_text, " ");
+		for (int r = first_row; r < layout->rows && y < view_rows_count; r++, y++) {
+			TerminalRow row = t_row(view_x(view, 0), view_y(view, y));
+			int start = layout->breaks[r];
+			int width = MIN(layout->breaks[r + 1] - start, view_cols_count);
 
-		int line_and_column_text_len = strlen(user_modifier_text);
+			if (width > 0)
+				t_row_blit(&row, 0, render_cache_line(source_file_line, start, width, CODE, syntax), width);
 
-		for (int i = 0; i < strlen(user_modifier_text); i++) {
-			current_grid[y][cols - i - 1].symbol = user_modifier_text[line_and_column_text_len - 1 - i];
+			for (int x = width; x < view_cols_count; x++)
+				t_row_set(&row, x, ' ', CLEAR);
 		}
-	} else if (mode_type == MODE_COMMAND) {
-		char command_text[MAX_COMMAND_SIZE] = {0};
-		sprintf(command_text, ":%s", command_mode_command.command);
+	}
 
-		for (int i = 0; i < strlen(command_text); i++) {
-			current_grid[y][i].symbol = command_text[i];
-		}
-	} else if (mode_type == MODE_INSERT) {
-		char* mode_name = "-- INSERT --";
+	for (; y < view_rows_count; y++) {
+		TerminalRow row = t_row(view_x(view, 0), view_y(view, y));
 
-		for (int i = 0; i < strlen(mode_name); i++) {
-			current_grid[y][i].symbol = mode_name[i];
-		}
+		for (int x = 0; x < view_cols_count; x++)
+			t_row_set(&row, x, ' ', CLEAR);
 	}
+
+	return source_file_line;
 }
 
-void draw_debug_information(ViewT* view, DebugInformation debug_info) {
-	EditorTabItemT* editor_tab_item = current_editor_tab->tab_item_current;
-	EditorWindow* editor_window = editor_tab_item->window;
-	int view_cols_count = view_cols(view);
-	int x_offset = editor_window->x_offset;
-	int y_offset = editor_window->y_offset;
-	Pos cursor_pos = editor_window->cursor_pos;
-	LineT* cursor_line = editor_window->cursor_line;
-	LineItemT* cursor_head = editor_window->cursor_line_item;
-	int total_rows = line_count_from(editor_window->editor_buffer->head_line);
+void draw_editor_window_source(EditorWindow* window) {
+	if (window->editor_buffer->hex != NULL) {
+		draw_editor_window_hex(window);
 
-	for (int y = view->origin.y; y < view->end.y; y++) {
-		int lineno = y - view->origin.y;
+		return;
+	}
+
+	ViewT* view = window->source_view;
+	EditorBufferT* buffer = window->editor_buffer;
+
+	int view_cols_count = view_visible_cols(view);
+	int view_rows_count = view_visible_rows(view);
+
+	LineT* source_file_line = editor_window_top_line(window);
+	SyntaxT* syntax = buffer->syntax;
+	uint8_t syntax_state = syntax_state_before(syntax, source_file_line, buffer->syntax_epoch);
+
+	if (editor_config.wrap) {
+		source_file_line = draw_editor_window_source_wrapped(window, source_file_line, &syntax_state);
+		syntax_converge(syntax, source_file_line, syntax_state, &buffer->syntax_epoch);
+
+		return;
+	}
+
+	for (int y = 0; y < view_rows_count; y++) {
+		TerminalRow row = t_row(view_x(view, 0), view_y(view, y));
+
+		if (source_file_line == NULL) {
+			for (int x = 0; x < view_cols_count; x++)
+				t_row_set(&row, x, ' ', CLEAR);
+
+			continue;
+		}
+
+		syntax_state = syntax_line_sync(syntax, source_file_line, syntax_state, buffer->syntax_epoch);
+		t_row_blit(&row, 0, render_cache_line(source_file_line, window->x_offset, view_cols_count, CODE, syntax), view_cols_count);
+
+		source_file_line = source_file_line->next;
+	}
+
+	syntax_converge(syntax, source_file_line, syntax_state, &buffer->syntax_epoch);
+}
+
+void draw_editor_window_status_column(EditorWindow* window) {
+	ViewT* view = window->status_column_view;
+	int y_offset = window->y_offset;
+	int total_rows = window->editor_buffer->lines_count;
+	int view_rows_count = view_visible_rows(view);
+	int view_cols_count = view_visible_cols(view);
+	bool wrap = editor_config.wrap && window->editor_buffer->hex == NULL;
+
+	EditorStatusColumnState state;
+	memset(&state, 0, sizeof(state));
+	state.generation = t_grid_generation;
+	state.x = view_x(view, 0);
+	state.y = view_y(view, 0);
+	state.rows = view_rows_count;
+	state.cols = view_cols_count;
+	state.y_offset = y_offset;
+	state.cursor_y = window->cursor_pos.y;
+	state.lines_count = total_rows;
+	state.buffer = window->editor_buffer;
+	state.version = wrap ? window->editor_buffer->version + 1 : 0;
+	state.wrap_width = wrap ? view_cols(window->source_view) : 0;
+	state.top_line_row = wrap ? editor_window_top_line_row(window, editor_window_top_line(window)) : 0;
+
+	if (!memcmp(&state, &window->drawn_status_column, sizeof(state)))
+		return;
+
+	window->drawn_status_column = state;
+
+	if (wrap) {
+		LineT* line = editor_window_top_line(window);
+		int line_rows = 0;
+		int line_index = y_offset;
+
+		if (line != NULL && state.top_line_row > 0)
+			line_rows = editor_window_line_rows(window, line) - state.top_line_row;
+
+		for (int y = 0; y < view_rows_count; y++) {
+			char column_text[16] = {0};
+
+			if (line != NULL && line_rows == 0) {
+				line_rows = editor_window_line_rows(window, line);
+				format_int(column_text, line_index + 1);
+			}
+
+			r_draw_line(view_x(view, 0), view_y(view, y), view_cols_count, column_text, line == window->cursor_line ? HIGHLIGHT : WHITE);
+
+			if (line != NULL && --line_rows == 0) {
+				line = line->next;
+				line_index++;
+			}
+		}
+
+		return;
+	}
+
+	for (int y = 0; y < view_rows_count; y++) {
+		char column_text[16] = {0};
+
+		if (y + y_offset + 1 <= total_rows)
+			format_int(column_text, y + y_offset + 1);
+
+		Color color = WHITE;
+
+		if (y == window->cursor_pos.y)
+			color = HIGHLIGHT;
+
+		r_draw_line(view_x(view, 0), view_y(view, y), view_cols_count, column_text, color);
+	}
+}
+
+void draw_editor_window_info_line_position(TerminalRow* row, int from, int cols, EditorInfoLineState* state) {
+	for (int x = from; x < cols; x++)
+		t_row_set(row, x, ' ', INFO_LINE);
+
+	for (int x = MAX(0, state->position_start); state->position[x - state->position_start] != 0 && x < cols - 1; x++)
+		t_row_set_symbol(row, x, state->position[x - state->position_start]);
+}
+
+void draw_editor_window_info_line(EditorWindow* window) {
+	ViewT* view = window->info_line_view;
+	char* filename = editor_buffer_name(window->editor_buffer);
+	int line = window->cursor_pos.y + window->y_offset;
+	int column = window->cursor_pos.x;
+	int view_cols_count = view_visible_cols(view);
+	int view_rows_count = view_visible_rows(view);
+
+	if (view_rows_count == 0)
+		return;
+
+	EditorInfoLineState* drawn = &window->drawn_info_line;
+	EditorInfoLineState state;
+	memset(&state, 0, sizeof(state));
+	state.generation = t_grid_generation;
+	state.x = view_x(view, 0);
+	state.y = view_y(view, 0);
+	state.rows = view_rows_count;
+	state.cols = view_cols_count;
+	state.filename = filename;
+	state.modified = window->editor_buffer->modified;
+
+	int position_len;
+
+	if (window->editor_buffer->hex != NULL) {
+		position_len = snprintf(state.position, sizeof(state.position), "0x%zx/0x%zx", editor_window_hex_offset(window), window->editor_buffer->hex->size);
+	} else {
+		position_len = format_int(state.position, line);
+		state.position[position_len++] = ',';
+		position_len += format_int(state.position + position_len, column);
+	}
+
+	state.position_start = view_cols_count - 1 - position_len;
+
+	bool layout_same = state.generation == drawn->generation &&
+		state.x == drawn->x && state.y == drawn->y &&
+		state.rows == drawn->rows && state.cols == drawn->cols &&
+		state.filename == drawn->filename && state.modified == drawn->modified;
+
+	if (layout_same && !strcmp(state.position, drawn->position))
+		return;
+
+	int filename_len = strlen(filename);
+	state.text_end = filename_len + (state.modified ? 4 : 0);
+
+	TerminalRow row = t_row(view_x(view, 0), view_y(view, 0));
+	int from = MIN(state.position_start, drawn->position_start);
+
+	if (layout_same && from >= state.text_end) {
+		draw_editor_window_info_line_position(&row, from, view_cols_count, &state);
+		*drawn = state;
+
+		return;
+	}
+
+	*drawn = state;
+
+	for (int y = 1; y < view_rows_count; y++) {
+		TerminalRow other_row = t_row(view_x(view, 0), view_y(view, y));
+
+		for (int x = 0; x < view_cols_count; x++) {
+			t_row_set(&other_row, x, ' ', INFO_LINE);
+		}
+	}
+
+	for (int x = 0; x < view_cols_count; x++) {
+		t_row_set(&row, x, x < filename_len ? filename[x] : ' ', INFO_LINE);
+	}
+
+	if (state.modified) {
+		char* modified_text = " [+]";
+
+		for (int x = 0; modified_text[x] != 0 && filename_len + x < view_cols_count; x++) {
+			t_row_set_symbol(&row, filename_len + x, modified_text[x]);
+		}
+	}
+
+	draw_editor_window_info_line_position(&row, view_cols_count, view_cols_count, &state);
+}
+
+void draw_cursor(EditorWindow* editor_window) {
+	ViewT* view = editor_window->source_view;
+	int x = editor_window->cursor_pos.x;
+	int y = editor_window->cursor_pos.y;
+
+	int view_cols_count = view_visible_cols(view);
+
+	if (y < 0 || y >= view_visible_rows(view))
+		return;
+
+	if (editor_window->editor_buffer->hex != NULL) {
+		if (hex_ascii_column_of_byte(x) < view_cols_count)
+			t_set_cell_style(view_x(view, hex_ascii_column_of_byte(x)), view_y(view, y), CURSOR);
+
+		x = hex_column_of_byte(x) + editor_window->hex_nibble;
+	} else if (editor_config.wrap) {
+		int wrap_row = editor_window_cursor_wrap_row(editor_window);
+
+		x -= wrap_layout(editor_window->cursor_line, view_cols(view))->breaks[wrap_row];
+		y = editor_window_cursor_screen_row(editor_window);
+	} else {
+		x -= editor_window->x_offset;
+	}
+
+	if (y < 0 || y >= view_visible_rows(view))
+		return;
+
+	if (x >= 0 && x < view_cols_count)
+		t_set_cell_style(view_x(view, x), view_y(view, y), CURSOR);
+}
+
+void highlight_line(EditorWindow* editor_window) {
+	int y = editor_window->cursor_pos.y;
+	int line_rows = 1;
+	ViewT* view = editor_window->source_view;
+	int view_cols_count = view_visible_cols(view);
+
+	if (editor_config.wrap && editor_window->editor_buffer->hex == NULL) {
+		y = editor_window_cursor_screen_row(editor_window) - editor_window_cursor_wrap_row(editor_window);
+		line_rows = editor_window_line_rows(editor_window, editor_window->cursor_line);
+	}
+
+	for (int r = MAX(0, y); r < y + line_rows && r < view_visible_rows(view); r++) {
+		TerminalRow row = t_row(view_x(view, 0), view_y(view, r));
+
+		for (int x = 0; x < view_cols_count; x++) {
+			t_row_set_style(&row, x, HIGHLIGHT);
+		}
+	}
+}
+
+void editor_window_scroll_drawn(EditorWindow* window) {
+	ViewT* source_view = window->source_view;
+	ViewT* status_column_view = window->status_column_view;
+	int shift = window->y_offset - window->drawn_y_offset;
+
+	window->drawn_y_offset = window->y_offset;
+
+	if (shift == 0 || editor_config.wrap || view_x(status_column_view, 0) != 0 || view_x(source_view, view_cols(source_view)) != t_grid_cols)
+		return;
+
+	t_scroll_rows(view_y(source_view, 0), view_y(source_view, view_rows(source_view)), shift);
+}
+
+void draw_editor_window(EditorWindow* window) {
+	editor_window_scroll_drawn(window);
+	draw_editor_window_source(window);
+	draw_editor_window_status_column(window);
+	draw_editor_window_info_line(window);
+}
+
+void draw_editor_tab_item(EditorTabT* editor_tab, EditorTabItemT* editor_tab_item) {
+	if (editor_tab_item == NULL)
+		return;
+
+	draw_editor_window(editor_tab_item->window);
+
+	if (editor_tab_item->tabno == editor_tab->tab_item_current->tabno) {
+		highlight_line(editor_tab_item->window);
+		draw_cursor(editor_tab_item->window);
+	}
+
+	draw_editor_tab_item(editor_tab, editor_tab_item->right);
+	draw_editor_tab_item(editor_tab, editor_tab_item->down);
+}
+
+void draw_editor_tab(EditorTabT* editor_tab) {
+	draw_editor_tab_item(editor_tab, editor_tab->tab_item_head);
+}
+
+void draw_command_line(ViewT* view) {
+	int cols = view_visible_cols(view);
+
+	if (view_visible_rows(view) == 0)
+		return;
+
+	TerminalRow row = t_row(view_x(view, 0), view_y(view, 0));
+
+	for (int x = 0; x < cols; x++) {
+		t_row_set(&row, x, ' ', CLEAR);
+	}
+
+	if (mode_type == MODE_NORMAL) {
+		for (int i = 0; message_line_data.message[i] != 0 && i < cols; i++) {
+			t_row_set_symbol(&row, i, message_line_data.message[i]);
+		}
+
+		char user_modifier_text[256] = {0};
+
+		if (normal_mode_command.count > 0)
+			sprintf(user_modifier_text, "%d", normal_mode_command.count);
+
+		if (strlen(normal_mode_command.command) > 0) {
+			char* printable_cmd = string_to_printable(normal_mode_command.command);
+			sprintf(user_modifier_text, "%s%s", user_modifier_text, printable_cmd);
+
+			free(printable_cmd);
+		}
+
+		if (strlen(user_modifier_text) == 0)
+			sprintf(user_modifier_text, " ");
+
+		int line_and_column_text_len = strlen(user_modifier_text);
+
+		for (int i = 0; i < line_and_column_text_len && i < cols; i++) {
+			t_row_set_symbol(&row, cols - i - 1, user_modifier_text[line_and_column_text_len - 1 - i]);
+		}
+	} else if (mode_type == MODE_COMMAND) {
+		char command_text[MAX_COMMAND_SIZE] = {0};
+		sprintf(command_text, ":%s", command_mode_command.command);
+
+		for (int i = 0; command_text[i] != 0 && i < cols; i++) {
+			t_row_set_symbol(&row, i, command_text[i]);
+		}
+	} else if (mode_type == MODE_INSERT) {
+		char* mode_name = "-- INSERT --";
+
+		for (int i = 0; mode_name[i] != 0 && i < cols; i++) {
+			t_row_set_symbol(&row, i, mode_name[i]);
+		}
+	}
+}
+
+void draw_debug_information(ViewT* view, DebugInformation debug_info) {
+	EditorTabItemT* editor_tab_item = current_editor_tab->tab_item_current;
+	EditorWindow* editor_window = editor_tab_item->window;
+	int view_cols_count = view_visible_cols(view);
+	int x_offset = editor_window->x_offset;
+	int y_offset = editor_window->y_offset;
+	Pos cursor_pos = editor_window->cursor_pos;
+	LineT* cursor_line = editor_window->cursor_line;
+	LineItemT* cursor_head = editor_window->cursor_line_item;
+	int total_rows = editor_window->editor_buffer->lines_count;
+	TerminalStats stats = t_stats_read();
+
+	for (int y = view->origin.y; y < view->end.y; y++) {
+		int lineno = y - view->origin.y;
 
 		char text[4096];
 
@@ -754,7 +1556,7 @@ void draw_debug_information(ViewT* view, DebugInformation debug_info) {
 			char line_text[256] = {};
 
 			int i = 0;
-			while (ch != NULL) {
+			while (ch != NULL && i < sizeof(line_text) - 1) {
 				line_text[i] = ch->symbol;
 				ch = ch->next;
 				i++;
@@ -763,6 +1565,55 @@ void draw_debug_information(ViewT* view, DebugInformation debug_info) {
 			sprintf(text, "current line %s", line_text);
 			r_draw_line(view_x(view, 0), y, view_cols_count, text, WHITE);
 		}
+
+		if (lineno == 5) {
+			sprintf(text, "last frame: %d rows, %d cells, %zuB in %d writes, total: %luB in %lu writes over %lu frames, %lu scrolls",
+				stats.rows_damaged,
+				stats.cells_visited,
+				stats.frame_bytes,
+				stats.frame_syscalls,
+				(unsigned long)stats.bytes,
+				(unsigned long)stats.syscalls,
+				(unsigned long)stats.frames,
+				(unsigned long)stats.scrolls);
+			r_draw_line(view->origin.x, y, view_cols_count, text, WHITE);
+		}
+
+		if (lineno == 6) {
+			sprintf(text, "frames rendered: %lu, skipped: %lu, line cache: %lu hits, %lu misses",
+				(unsigned long)editor_frame_stats.rendered,
+				(unsigned long)editor_frame_stats.skipped,
+				(unsigned long)render_cache.hits,
+				(unsigned long)render_cache.misses);
+			r_draw_line(view->origin.x, y, view_cols_count, text, WHITE);
+		}
+
+		if (lineno == 7) {
+			sprintf(text, "wrap: %s, wrap cache: %lu hits, %lu misses, syntax: %s",
+				editor_config.wrap ? "on" : "off",
+				(unsigned long)wrap_cache.hits,
+				(unsigned long)wrap_cache.misses,
+				editor_window->editor_buffer->syntax != NULL ? editor_window->editor_buffer->syntax->name : "none");
+			r_draw_line(view->origin.x, y, view_cols_count, text, WHITE);
+		}
+
+		if (lineno == 8) {
+			sprintf(text, "resizes: %lu, resize to frame: %luus last, %luus max",
+				(unsigned long)editor_frame_stats.resizes,
+				(unsigned long)(editor_frame_stats.resize_ns_last / 1000),
+				(unsigned long)(editor_frame_stats.resize_ns_max / 1000));
+			r_draw_line(view->origin.x, y, view_cols_count, text, WHITE);
+		}
+
+		if (lineno == 9) {
+			sprintf(text, "render thread: %s, frames published: %lu, dropped: %lu, queue latency: %luus last, %luus max",
+				t_thread.running ? "on" : "off",
+				(unsigned long)stats.frames_published,
+				(unsigned long)stats.frames_dropped,
+				(unsigned long)(stats.queue_ns_last / 1000),
+				(unsigned long)(stats.queue_ns_max / 1000));
+			r_draw_line(view->origin.x, y, view_cols_count, text, WHITE);
+		}
 	}
 }
 
@@ -1084,6 +1935,60 @@ void offset_sync_with_cursor(int* y_offset, Pos* cursor_pos, int rows, int total
 	}
 }
 
+void offset_sync_with_cursor_column(int* x_offset, Pos* cursor_pos, int cols) {
+	if (cursor_pos->x < *x_offset) {
+		*x_offset = cursor_pos->x;
+	} else if (cursor_pos->x >= *x_offset + cols) {
+		*x_offset = cursor_pos->x - cols + 1;
+	}
+}
+
+void offset_sync_with_cursor_wrapped(EditorWindow* window, int rows) {
+	LineT* line = window->cursor_line;
+	int cursor_row = editor_window_cursor_wrap_row(window);
+	int screen_row = editor_window_cursor_screen_row(window);
+
+	if (window->cursor_pos.y >= 0 && screen_row >= 0 && screen_row < rows)
+		return;
+
+	int used = cursor_row + 1;
+	int fit = 0;
+
+	while (fit < window->cursor_pos.y && line->prev != NULL) {
+		int line_rows = editor_window_line_rows(window, line->prev);
+
+		if (used + line_rows > rows)
+			break;
+
+		used += line_rows;
+		line = line->prev;
+		fit++;
+	}
+
+	int shift = window->cursor_pos.y - fit;
+
+	window->y_offset += shift;
+	window->cursor_pos.y -= shift;
+	window->top_line_id = line->id;
+	window->top_line_row = 0;
+
+	// A cursor line taller than the view is scrolled within itself, by as few
+	// rows as it takes to bring the cursor row back into view.
+	if (fit == 0 && (shift < 0 || screen_row < 0))
+		window->top_line_row = cursor_row;
+	else if (fit == 0)
+		window->top_line_row = MAX(0, cursor_row - rows + 1);
+}
+
+void editor_window_sync_cursor(EditorWindow* window, int rows, int cols) {
+	if (editor_config.wrap) {
+		window->x_offset = 0;
+		offset_sync_with_cursor_wrapped(window, rows);
+	} else {
+		offset_sync_with_cursor_column(&window->x_offset, &window->cursor_pos, cols);
+	}
+}
+
 int insert_insert_symbol(LineT* current_line, LineItemT* current_line_item, char symbol) {
 	int shift = nav_move_count_by_source_symbol(symbol);
 
@@ -1131,28 +2036,802 @@ int insert_delete_symbol(LineT** line, LineItemT** line_item) {
 	return shift;
 }
 
-void normal_mode_command_clear() {
-	normal_mode_command.count = 0;
+void editor_window_insert_symbol(EditorWindow* editor_window, char symbol) {
+	EditorBufferT* editor_buffer = editor_window->editor_buffer;
+	LineT** cursor_line = &editor_window->cursor_line;
+	LineItemT** cursor_line_item = &editor_window->cursor_line_item;
+	Pos* cursor_pos = &editor_window->cursor_pos;
 
-	sprintf(normal_mode_command.command, "");
-}
+	editor_buffer_prepare_edit(editor_buffer);
 
-void normal_mode_command_add_count(int count) {
-	normal_mode_command.count = normal_mode_command.count * 10 + count;
-}
+	if (symbol_is_backspace(symbol)) {
+		int shift = insert_delete_symbol(cursor_line, cursor_line_item);
+		cursor_backward(cursor_pos, shift);
 
-bool normal_mode_command_is_valid_partial() {
-	int i = 0;
+		if (shift > 0)
+			editor_buffer_touch(editor_buffer, *cursor_line);
 
-	while (strcmp("-1", conf_normal_mode_valid_commands[i])) {
-		if (!strncmp(normal_mode_command.command, conf_normal_mode_valid_commands[i], strlen(normal_mode_command.command)))
-			return true;
+		if (shift == 0 && editor_window->cursor_line->prev != NULL) {
+			if (line_item_is_newline(editor_window->cursor_line->prev->item_head)) {
+				line_delete_before(*cursor_line);
+				cursor_up(cursor_pos, 1);
+				editor_buffer_touch(editor_buffer, NULL);
+				editor_buffer->lines_count--;
 
-		i++;
-	}
+				if ((*cursor_line)->prev == NULL)
+					editor_buffer->head_line = *cursor_line;
+			} else {
+				nav_up(cursor_line, cursor_line_item, cursor_pos, 1);
+				nav_to_end_of_line(cursor_line_item, cursor_pos);
+				nav_backward(cursor_line_item, cursor_pos);
+				line_concat_after(*cursor_line);
+				cursor_forward(cursor_pos, 1);
+				line_item_next(cursor_line_item);
+				editor_buffer_touch(editor_buffer, *cursor_line);
+				editor_buffer->lines_count--;
+
+				if ((*cursor_line)->next == NULL)
+					editor_buffer->tail_line = *cursor_line;
+			}
+		}
+	} else if (symbol_is_enter(symbol)) {
+		LineT* current_line = *cursor_line;
+		LineItemT* line_tail = *cursor_line_item;
+		LineItemT* new_end_of_current_line = line_tail->prev;
 
-	return false;
-}
+		line_new_after(cursor_line);
+		nav_down(cursor_line, cursor_line_item, cursor_pos, 1);
+
+		LineItemT* new_line_terminator = line_find_next_symbol(*cursor_line, '\n');
+
+		line_set_head(*cursor_line, line_tail);
+
+		if (new_end_of_current_line != NULL) {
+			new_end_of_current_line->next = new_line_terminator;
+			new_line_terminator->prev = new_end_of_current_line;
+		} else {
+			current_line->item_head = new_line_terminator;
+		}
+
+		*cursor_line_item = (*cursor_line)->item_head;
+
+		editor_buffer_touch(editor_buffer, current_line);
+		editor_buffer_touch(editor_buffer, *cursor_line);
+		editor_buffer->lines_count++;
+
+		if ((*cursor_line)->next == NULL)
+			editor_buffer->tail_line = *cursor_line;
+	} else if (symbol_is_printable(symbol)) {
+		int shift = insert_insert_symbol(editor_window->cursor_line, editor_window->cursor_line_item, symbol);
+		cursor_forward(cursor_pos, shift);
+		editor_buffer_touch(editor_buffer, *cursor_line);
+	}
+}
+
+void editor_buffer_journal_insert(EditorWindow* editor_window, char symbol) {
+	EditorBufferT* buffer = editor_window->editor_buffer;
+
+	if (!strcmp("", buffer->filename) || buffer->journal_pending)
+		return;
+
+	// journal_create never truncates, an ignored journal from an earlier
+	// session keeps its file and the new edits go to the next free one.
+	for (int i = 0; buffer->journal == NULL && i < JOURNAL_MAX_FILES; i++) {
+		char* path = journal_path_for_index(buffer->filename, i);
+
+		buffer->journal = journal_create(path, editor_buffer_journal_header(buffer));
+
+		free(path);
+	}
+
+	if (buffer->journal == NULL)
+		return;
+
+	uint32_t column = 0;
+
+	for (LineItemT* item = editor_window->cursor_line_item->prev; item != NULL; item = item->prev)
+		column++;
+
+	JournalRecord record = {
+		.line = editor_window->y_offset + editor_window->cursor_pos.y,
+		.column = column,
+		.symbol = symbol,
+	};
+
+	journal_append(buffer->journal, record);
+}
+
+void editor_buffer_journal_apply(JournalRecord* record, void* context) {
+	EditorWindow* window = (EditorWindow*)context;
+
+	while (window->cursor_pos.y < record->line && window->cursor_line->next != NULL) {
+		window->cursor_line = window->cursor_line->next;
+		window->cursor_pos.y++;
+	}
+
+	while (window->cursor_pos.y > record->line && window->cursor_line->prev != NULL) {
+		window->cursor_line = window->cursor_line->prev;
+		window->cursor_pos.y--;
+	}
+
+	window->cursor_line_item = window->cursor_line->item_head;
+	window->cursor_pos.x = 0;
+
+	for (uint32_t i = 0; i < record->column && window->cursor_line_item->next != NULL; i++)
+		nav_forward(&window->cursor_line_item, &window->cursor_pos);
+
+	editor_window_insert_symbol(window, record->symbol);
+}
+
+uint64_t editor_buffer_replay_journal(EditorBufferT* buffer, char* path) {
+	EditorWindow window = {
+		.editor_buffer = buffer,
+		.cursor_line = buffer->head_line,
+		.cursor_line_item = buffer->head_line->item_head,
+		.cursor_pos = {.x = 0, .y = 0},
+		.x_offset = 0,
+		.y_offset = 0,
+	};
+
+	return journal_replay(path, editor_buffer_journal_apply, &window);
+}
+
+// Journals of modified buffers are kept even on a clean quit, they hold the
+// only copy of the unsaved edits (recovered ones included).
+void editor_buffers_close_journals(bool remove) {
+	for (EditorBufferT* buffer = buffers; buffer != NULL; buffer = buffer->next) {
+		if (buffer->journal == NULL)
+			continue;
+
+		journal_close(buffer->journal, remove && !buffer->modified);
+		buffer->journal = NULL;
+	}
+}
+
+void editor_window_relocate_cursor(EditorWindow* window, int line_index, int x) {
+	LineT* line = window->editor_buffer->head_line;
+	int index = 0;
+
+	while (index < line_index && line->next != NULL) {
+		line = line->next;
+		index++;
+	}
+
+	window->cursor_line = line;
+	window->cursor_line_item = line->item_head;
+	window->cursor_pos.x = 0;
+
+	nav_oneline_distance(nav_forward, &window->cursor_line_item, &window->cursor_pos, x);
+
+	window->y_offset = MIN(window->y_offset, index);
+	window->cursor_pos.y = index - window->y_offset;
+	editor_window_sync_cursor(window, view_rows(window->source_view), view_cols(window->source_view));
+}
+
+// Windows keep their cursor as a line index and column, relocating from those
+// re-resolves the line pointers after the buffer's lines were replaced.
+void editor_tab_item_relocate_cursors(EditorTabItemT* editor_tab_item, EditorBufferT* buffer) {
+	if (editor_tab_item == NULL)
+		return;
+
+	EditorWindow* window = editor_tab_item->window;
+
+	if (window->editor_buffer == buffer)
+		editor_window_relocate_cursor(window, window->y_offset + window->cursor_pos.y, window->cursor_pos.x);
+
+	editor_tab_item_relocate_cursors(editor_tab_item->right, buffer);
+	editor_tab_item_relocate_cursors(editor_tab_item->down, buffer);
+}
+
+void editor_buffer_relocate_cursors(EditorBufferT* buffer) {
+	EditorTabT* editor_tab = current_editor_tab;
+
+	while (editor_tab->prev != NULL)
+		editor_tab = editor_tab->prev;
+
+	for (; editor_tab != NULL; editor_tab = editor_tab->next)
+		editor_tab_item_relocate_cursors(editor_tab->tab_item_head, buffer);
+}
+
+// The append fast path is only safe when the file is the same inode and the
+// bytes the buffer was built from are still its prefix.
+bool editor_buffer_disk_prefix_matches(EditorBufferT* buffer, int fd, struct stat* st) {
+	if (st->st_dev != buffer->saved_dev || st->st_ino != buffer->saved_ino)
+		return false;
+
+	char chunk[64 * 1024];
+	uint64_t hash = LINE_HASH_OFFSET;
+	off_t from = 0;
+
+	while (from < buffer->saved_size) {
+		ssize_t n = pread(fd, chunk, MIN((off_t)sizeof(chunk), buffer->saved_size - from), from);
+
+		if (n <= 0)
+			return false;
+
+		hash = line_hash_bytes(hash, chunk, n);
+		from += n;
+	}
+
+	return hash == buffer->saved_bytes_hash;
+}
+
+int editor_buffer_append_from_disk(EditorBufferT* buffer, int fd, off_t from, off_t* to) {
+	char chunk[64 * 1024];
+	int lines_added = 0;
+	ssize_t n;
+
+	while ((n = pread(fd, chunk, sizeof(chunk), from)) > 0) {
+		lines_added += editor_buffer_append_bytes(buffer, chunk, n);
+		buffer->saved_bytes_hash = line_hash_bytes(buffer->saved_bytes_hash, chunk, n);
+		from += n;
+	}
+
+	*to = from;
+
+	return lines_added;
+}
+
+void editor_buffer_reload(EditorBufferT* buffer) {
+	int fd = open(buffer->filename, O_RDONLY);
+
+	if (fd < 0)
+		return;
+
+	struct stat st;
+	fstat(fd, &st);
+
+	char message[MAX_MESSAGE_SIZE] = {0};
+
+	if (!buffer->compressed && buffer->saved_size > 0 && st.st_size > buffer->saved_size &&
+			editor_buffer_disk_prefix_matches(buffer, fd, &st)) {
+		off_t size;
+		int lines_added = editor_buffer_append_from_disk(buffer, fd, buffer->saved_size, &size);
+
+		snprintf(message, MAX_MESSAGE_SIZE, "\"%s\" grew by %ldB, %d new lines",
+			buffer->filename,
+			(long)(size - buffer->saved_size),
+			lines_added);
+
+		buffer->saved_size = size;
+		buffer->saved_mtime = st.st_mtim;
+	} else {
+		int first_changed, removed, added;
+		SourceFileT source;
+
+		read_source_file(buffer->filename, &source);
+
+		editor_buffer_set_lines(buffer, line_splice_changed(buffer->head_line, source.head_line, &first_changed, &removed, &added));
+
+		buffer->compressed = source.compressed;
+		editor_buffer_mark_source(buffer, &source);
+
+		editor_buffer_relocate_cursors(buffer);
+
+		snprintf(message, MAX_MESSAGE_SIZE, "\"%s\" reloaded from line %d, %d lines removed, %d added",
+			buffer->filename,
+			first_changed + 1,
+			removed,
+			added);
+	}
+
+	close(fd);
+
+	buffer->saved_hash_valid = false;
+	buffer->version++;
+
+	if (buffer->journal != NULL)
+		journal_rebase(buffer->journal, buffer->journal->records_count, editor_buffer_journal_header(buffer));
+
+	message_set(message);
+}
+
+void editor_window_pin_to_bottom(EditorWindow* window) {
+	EditorBufferT* buffer = window->editor_buffer;
+
+	window->cursor_line = buffer->tail_line;
+	window->cursor_line_item = buffer->tail_line->item_head;
+	window->cursor_pos.x = 0;
+	window->x_offset = 0;
+	window->y_offset = MAX(0, buffer->lines_count - view_rows(window->source_view));
+	window->cursor_pos.y = buffer->lines_count - 1 - window->y_offset;
+}
+
+void editor_tab_item_mark_pinned(EditorTabItemT* editor_tab_item, EditorBufferT* buffer) {
+	if (editor_tab_item == NULL)
+		return;
+
+	EditorWindow* window = editor_tab_item->window;
+
+	window->pinned = window->editor_buffer == buffer &&
+		window->y_offset + window->cursor_pos.y == buffer->lines_count - 1;
+
+	editor_tab_item_mark_pinned(editor_tab_item->right, buffer);
+	editor_tab_item_mark_pinned(editor_tab_item->down, buffer);
+}
+
+void editor_tab_item_pin_marked(EditorTabItemT* editor_tab_item) {
+	if (editor_tab_item == NULL)
+		return;
+
+	if (editor_tab_item->window->pinned)
+		editor_window_pin_to_bottom(editor_tab_item->window);
+
+	editor_tab_item_pin_marked(editor_tab_item->right);
+	editor_tab_item_pin_marked(editor_tab_item->down);
+}
+
+void editor_tab_item_pin_all(EditorTabItemT* editor_tab_item, EditorBufferT* buffer) {
+	if (editor_tab_item == NULL)
+		return;
+
+	if (editor_tab_item->window->editor_buffer == buffer)
+		editor_window_pin_to_bottom(editor_tab_item->window);
+
+	editor_tab_item_pin_all(editor_tab_item->right, buffer);
+	editor_tab_item_pin_all(editor_tab_item->down, buffer);
+}
+
+void editor_buffer_follow_disk(EditorBufferT* buffer) {
+	int fd = open(buffer->filename, O_RDONLY);
+
+	if (fd < 0)
+		return;
+
+	struct stat st;
+	fstat(fd, &st);
+
+	if (st.st_size < buffer->saved_size || buffer->saved_size < 0 ||
+			st.st_dev != buffer->saved_dev || st.st_ino != buffer->saved_ino) {
+		close(fd);
+		editor_buffer_reload(buffer);
+		editor_tab_item_mark_pinned(current_editor_tab->tab_item_head, buffer);
+		editor_tab_item_pin_marked(current_editor_tab->tab_item_head);
+
+		return;
+	}
+
+	if (st.st_size > buffer->saved_size) {
+		editor_tab_item_mark_pinned(current_editor_tab->tab_item_head, buffer);
+		editor_buffer_append_from_disk(buffer, fd, buffer->saved_size, &buffer->saved_size);
+		editor_tab_item_pin_marked(current_editor_tab->tab_item_head);
+
+		buffer->saved_hash_valid = false;
+	}
+
+	buffer->saved_mtime = st.st_mtim;
+	close(fd);
+}
+
+void editor_buffer_set_follow(EditorBufferT* buffer, bool follow) {
+	char message[MAX_MESSAGE_SIZE] = {0};
+
+	if (follow && !strcmp("", buffer->filename)) {
+		message_set("E32: No file name");
+
+		return;
+	}
+
+	if (follow && buffer->compressed) {
+		snprintf(message, MAX_MESSAGE_SIZE, "E: can't follow compressed \"%s\"", buffer->filename);
+		message_set(message);
+
+		return;
+	}
+
+	if (follow && buffer->modified) {
+		snprintf(message, MAX_MESSAGE_SIZE, "E: \"%s\" has unsaved changes, can't follow", buffer->filename);
+		message_set(message);
+
+		return;
+	}
+
+	buffer->follow = follow;
+
+	if (follow) {
+		editor_buffer_follow_disk(buffer);
+
+		editor_tab_item_pin_all(current_editor_tab->tab_item_head, buffer);
+	}
+
+	snprintf(message, MAX_MESSAGE_SIZE, "\"%s\" follow %s", buffer->filename, follow ? "on" : "off");
+	message_set(message);
+}
+
+void editor_buffer_check_disk(EditorBufferT* buffer) {
+	if (buffer->follow && buffer->modified && buffer->writes_in_flight == 0 && !editor_buffer_disk_unchanged(buffer)) {
+		off_t size;
+
+		buffer->follow = false;
+
+		char message[MAX_MESSAGE_SIZE] = {0};
+		snprintf(message, MAX_MESSAGE_SIZE, "W: \"%s\" changed on disk since editing started, follow off", buffer->filename);
+		message_set(message);
+
+		editor_buffer_stat_disk(buffer, &size, &buffer->warned_mtime);
+
+		return;
+	}
+
+	if (buffer->follow) {
+		editor_buffer_follow_disk(buffer);
+
+		return;
+	}
+
+	if (buffer->writes_in_flight > 0 || editor_buffer_disk_unchanged(buffer))
+		return;
+
+	off_t size;
+	struct timespec mtime;
+
+	editor_buffer_stat_disk(buffer, &size, &mtime);
+
+	if (size < 0)
+		return;
+
+	if (buffer->modified) {
+		if (mtime.tv_sec == buffer->warned_mtime.tv_sec && mtime.tv_nsec == buffer->warned_mtime.tv_nsec)
+			return;
+
+		buffer->warned_mtime = mtime;
+
+		char message[MAX_MESSAGE_SIZE] = {0};
+		snprintf(message, MAX_MESSAGE_SIZE, "W: \"%s\" changed on disk since editing started", buffer->filename);
+		message_set(message);
+
+		return;
+	}
+
+	editor_buffer_reload(buffer);
+}
+
+void handle_watch_event(int wd, char* name, void* context) {
+	for (EditorBufferT* buffer = buffers; buffer != NULL; buffer = buffer->next) {
+		if (buffer->watch_wd == wd && !strcmp(name, watch_basename(buffer->filename)))
+			buffer->disk_changed = true;
+	}
+}
+
+void process_watch_events() {
+	watch_read_events(handle_watch_event, NULL);
+}
+
+void process_disk_changes() {
+	for (EditorBufferT* buffer = buffers; buffer != NULL; buffer = buffer->next) {
+		if (!buffer->disk_changed)
+			continue;
+
+		buffer->disk_changed = false;
+		editor_buffer_check_disk(buffer);
+	}
+}
+
+void editor_tab_item_reset_cursors(EditorTabItemT* editor_tab_item, EditorBufferT* buffer) {
+	if (editor_tab_item == NULL)
+		return;
+
+	if (editor_tab_item->window->editor_buffer == buffer)
+		editor_window_relocate_cursor(editor_tab_item->window, 0, 0);
+
+	editor_tab_item_reset_cursors(editor_tab_item->right, buffer);
+	editor_tab_item_reset_cursors(editor_tab_item->down, buffer);
+}
+
+void editor_buffer_check_journal(EditorBufferT* buffer) {
+	for (int i = 0; i < JOURNAL_MAX_FILES; i++) {
+		char* path = journal_path_for_index(buffer->filename, i);
+		JournalHeader header;
+		uint64_t records_count = 0;
+
+		if (journal_read_header(path, &header, &records_count)) {
+			if (records_count == 0) {
+				unlink(path);
+			} else if (!buffer->journal_pending) {
+				buffer->journal_pending = true;
+				buffer->journal_index = i;
+			}
+		}
+
+		free(path);
+	}
+}
+
+void editor_buffer_offer_journal(EditorBufferT* buffer) {
+	if (!buffer->journal_pending || buffer->loading)
+		return;
+
+	char* path = journal_path_for_index(buffer->filename, buffer->journal_index);
+	JournalHeader header;
+	uint64_t records_count = 0;
+
+	if (!journal_read_header(path, &header, &records_count) || records_count == 0) {
+		buffer->journal_pending = false;
+		free(path);
+
+		return;
+	}
+
+	JournalHeader current = editor_buffer_journal_header(buffer);
+	bool stale = header.source_size != current.source_size ||
+		header.source_mtime_sec != current.source_mtime_sec ||
+		header.source_mtime_nsec != current.source_mtime_nsec;
+
+	char message[MAX_MESSAGE_SIZE] = {0};
+	snprintf(message, MAX_MESSAGE_SIZE, "Found swap journal %s with %lu edits%s. [r]ecover, [d]elete, [i]gnore",
+		path,
+		(unsigned long)records_count,
+		stale ? " (file changed on disk since)" : "");
+	message_set(message);
+
+	journal_prompt_buffer = buffer;
+	free(path);
+}
+
+void editor_buffer_answer_journal(char answer) {
+	EditorBufferT* buffer = journal_prompt_buffer;
+	char* path = journal_path_for_index(buffer->filename, buffer->journal_index);
+	JournalHeader header;
+	uint64_t records_count = 0;
+	char message[MAX_MESSAGE_SIZE] = {0};
+
+	journal_prompt_buffer = NULL;
+	buffer->journal_pending = false;
+
+	if (answer == 'r' && journal_read_header(path, &header, &records_count)) {
+		editor_buffer_replay_journal(buffer, path);
+		buffer->journal = journal_open_append(path, records_count);
+		editor_tab_item_reset_cursors(current_editor_tab->tab_item_head, buffer);
+
+		snprintf(message, MAX_MESSAGE_SIZE, "Recovered %lu edits from %s", (unsigned long)records_count, path);
+	} else if (answer == 'd') {
+		unlink(path);
+
+		snprintf(message, MAX_MESSAGE_SIZE, "Deleted swap journal %s", path);
+	}
+
+	message_set(message);
+	free(path);
+}
+
+bool editor_buffer_is_pristine_placeholder(EditorBufferT* buffer) {
+	LineT* head_line = buffer->head_line;
+
+	return !buffer->modified && head_line->next == NULL &&
+		line_item_is_newline(head_line->item_head) && head_line->item_head->next == NULL;
+}
+
+bool process_stream_input() {
+	EditorBufferT* buffer = streaming_buffer;
+
+	if (buffer == NULL)
+		return false;
+
+	for (int i = 0; i < STREAM_CHUNKS_PER_FRAME; i++) {
+		StreamChunkT* chunk = stream_take(buffer->stream);
+
+		if (chunk == NULL)
+			break;
+
+		if (buffer->stream_bytes == 0 && editor_buffer_is_pristine_placeholder(buffer)) {
+			LineT* placeholder = buffer->head_line;
+
+			buffer->tail_line = NULL;
+			buffer->lines_count = 0;
+			editor_buffer_append_bytes(buffer, chunk->data, chunk->size);
+			buffer->head_line = line_find_top(buffer->tail_line);
+
+			editor_tab_item_reset_cursors(current_editor_tab->tab_item_head, buffer);
+			line_free(placeholder);
+		} else {
+			editor_buffer_append_bytes(buffer, chunk->data, chunk->size);
+		}
+
+		buffer->stream_bytes += chunk->size;
+		free(chunk);
+	}
+
+	if (stream_finished(buffer->stream)) {
+		stream_free(buffer->stream);
+		buffer->stream = NULL;
+		streaming_buffer = NULL;
+
+		char message[MAX_MESSAGE_SIZE] = {0};
+		snprintf(message, MAX_MESSAGE_SIZE, "[stdin] %d lines, %luB read",
+			buffer->lines_count,
+			(unsigned long)buffer->stream_bytes);
+		message_set(message);
+
+		return false;
+	}
+
+	return stream_has_chunks(buffer->stream);
+}
+
+void editor_buffer_finish_load(EditorBufferT* buffer, SourceFileT* source) {
+	LineT* placeholder = buffer->head_line;
+
+	editor_buffer_set_lines(buffer, source->head_line);
+	buffer->compressed = source->compressed;
+	buffer->loading = false;
+	buffer->saved_hash_valid = false;
+	editor_buffer_mark_source(buffer, source);
+
+	editor_tab_item_reset_cursors(current_editor_tab->tab_item_head, buffer);
+	line_free(placeholder);
+	free(source);
+
+	editor_buffer_check_journal(buffer);
+
+	if (buffer->journal_pending && current_editor_tab->tab_item_current->window->editor_buffer == buffer && journal_prompt_buffer == NULL) {
+		char message[MAX_MESSAGE_SIZE] = {0};
+		snprintf(message, MAX_MESSAGE_SIZE, "\"%s\" has a swap journal, switch back to it with :bn or :bp to recover", buffer->filename);
+		message_set(message);
+	}
+
+	buffer->watch_wd = watch_add(buffer->filename);
+}
+
+int process_io_results() {
+	int failed = 0;
+	IoJobT* job;
+
+	while ((job = io_take_done()) != NULL) {
+		char message[MAX_MESSAGE_SIZE] = {0};
+
+		if (job->type == IO_JOB_READ) {
+			editor_buffer_finish_load((EditorBufferT*)job->owner, (SourceFileT*)job->result);
+			io_batch_finish((IoBatchT*)job->batch, false, "loaded");
+			io_job_free(job);
+
+			continue;
+		}
+
+		((EditorBufferT*)job->owner)->writes_in_flight--;
+
+		if (job->error != 0) {
+			snprintf(message, MAX_MESSAGE_SIZE, "E: can't write \"%s\": %s", job->filename, strerror(job->error));
+			failed++;
+		} else {
+			EditorBufferT* buffer = (EditorBufferT*)job->owner;
+
+			editor_buffer_mark_saved(buffer, job->content_hash, job->data_hash);
+
+			if (buffer->journal != NULL)
+				journal_rebase(buffer->journal, job->journal_checkpoint, editor_buffer_journal_header(buffer));
+
+			if (buffer->version == job->version)
+				buffer->modified = false;
+
+			snprintf(message, MAX_MESSAGE_SIZE, "\"%s\" %zuB written", job->filename, job->size);
+		}
+
+		message_set(message);
+		io_batch_finish((IoBatchT*)job->batch, job->error != 0, "written");
+		io_job_free(job);
+	}
+
+	return failed;
+}
+
+int editor_buffers_count() {
+	int count = 0;
+
+	for (EditorBufferT* buffer = buffers; buffer != NULL; buffer = buffer->next)
+		count++;
+
+	return count;
+}
+
+void editor_window_switch_buffer(EditorWindow* window, int direction) {
+	int count = editor_buffers_count();
+	int index = 0;
+
+	for (EditorBufferT* buffer = buffers; buffer != window->editor_buffer; buffer = buffer->next)
+		index++;
+
+	index = ((index + direction) % count + count) % count;
+
+	EditorBufferT* buffer = buffers;
+
+	while (index-- > 0)
+		buffer = buffer->next;
+
+	window->editor_buffer = buffer;
+	window->y_offset = 0;
+	window->hex_nibble = 0;
+
+	editor_window_relocate_cursor(window, 0, 0);
+
+	char message[MAX_MESSAGE_SIZE] = {0};
+	snprintf(message, MAX_MESSAGE_SIZE, "\"%s\"%s %d lines",
+		editor_buffer_name(buffer),
+		buffer->loading ? " [loading]" : "",
+		buffer->lines_count);
+	message_set(message);
+
+	editor_buffer_offer_journal(buffer);
+}
+
+void* editor_load_source_file(char* filename, bool* compressed) {
+	SourceFileT* source = (SourceFileT*)malloc(sizeof(SourceFileT));
+
+	read_source_file(filename, source);
+	*compressed = source->compressed;
+
+	return source;
+}
+
+EditorBufferT* editor_buffer_open(char* filename) {
+	EditorBufferT* editor_buffer = editor_buffer_find_by_filename(filename);
+
+	if (editor_buffer != NULL)
+		return editor_buffer;
+
+	editor_buffer = editor_buffer_new();
+
+	if (!strcmp("-", filename)) {
+		editor_buffer_set_lines(editor_buffer, line_new(line_item_new('\n')));
+		editor_buffer->stream = stream_start(STDIN_FILENO);
+		streaming_buffer = editor_buffer;
+	} else if (strcmp("", filename) && (editor_config.hex || hex_file_is_binary(filename)) &&
+			(editor_buffer->hex = hex_open(filename)) != NULL) {
+		editor_buffer_set_lines(editor_buffer, line_new(line_item_new('\n')));
+		editor_buffer->lines_count = MAX(1, hex_rows(editor_buffer->hex));
+		editor_buffer->filename = filename;
+
+		editor_buffer_mark_loaded(editor_buffer);
+	} else if (strcmp("", filename)) {
+		editor_buffer_set_lines(editor_buffer, line_new(line_item_new('\n')));
+		editor_buffer->filename = filename;
+		editor_buffer->syntax = syntax_for_filename(filename);
+		editor_buffer->loading = true;
+
+		IoJobT* job = io_job_new_read(filename, editor_load_source_file, editor_buffer);
+
+		io_batch_add(&load_batch, job);
+		io_submit(job);
+	} else {
+		LineItemT* head_line_item = line_item_new('\n');
+
+		editor_buffer_set_lines(editor_buffer, line_new(head_line_item));
+		editor_buffer->filename = "";
+	}
+
+	return editor_buffer;
+}
+
+void editor_buffer_wait_loaded(EditorBufferT* buffer) {
+	while (buffer->loading) {
+		struct pollfd poll_fd = {.fd = io_notify_fd(), .events = POLLIN};
+
+		poll(&poll_fd, 1, -1);
+		process_io_results();
+	}
+}
+
+void normal_mode_command_clear() {
+	normal_mode_command.count = 0;
+
+	sprintf(normal_mode_command.command, "");
+}
+
+void normal_mode_command_add_count(int count) {
+	normal_mode_command.count = normal_mode_command.count * 10 + count;
+}
+
+bool normal_mode_command_is_valid_partial() {
+	int i = 0;
+
+	while (strcmp("-1", conf_normal_mode_valid_commands[i])) {
+		if (!strncmp(normal_mode_command.command, conf_normal_mode_valid_commands[i], strlen(normal_mode_command.command)))
+			return true;
+
+		i++;
+	}
+
+	return false;
+}
 
 bool normal_mode_command_is_valid_full() {
 	int i = 0;
@@ -1189,6 +2868,9 @@ void command_mode_strip_tail() {
 bool command_mode_command_is_valid() {
 	int i = 0;
 
+	if (!strncmp("goto ", command_mode_command.command, 5))
+		return true;
+
 	while (strcmp("-1", conf_command_mode_valid_commands[i])) {
 		if (!strcmp(conf_command_mode_valid_commands[i], command_mode_command.command))
 			return true;
@@ -1315,6 +2997,18 @@ bool handle_normal_mode_command(int* read_index, int* write_index) {
 	if (!strcmp("\x15", normal_mode_command.command))
 		return add_user_command_with_no_data(read_index, write_index, UC_CTRL_u, normal_mode_command.count);
 
+	if (!strcmp("zl", normal_mode_command.command))
+		return add_user_command_with_no_data(read_index, write_index, UC_zl, normal_mode_command.count);
+
+	if (!strcmp("zh", normal_mode_command.command))
+		return add_user_command_with_no_data(read_index, write_index, UC_zh, normal_mode_command.count);
+
+	if (!strcmp("zs", normal_mode_command.command))
+		return add_user_command_with_no_data(read_index, write_index, UC_zs, normal_mode_command.count);
+
+	if (!strcmp("ze", normal_mode_command.command))
+		return add_user_command_with_no_data(read_index, write_index, UC_ze, normal_mode_command.count);
+
 	if (!strcmp("\x1b", normal_mode_command.command))
 		return add_user_command_with_no_data(read_index, write_index, UC_esc, normal_mode_command.count);
 
@@ -1341,6 +3035,31 @@ bool handle_command_mode_command(int* read_index, int* write_index) {
 		return add_user_command_with_no_data(read_index, write_index, UC_SAVE_FILE, normal_mode_command.count);
 
 
+	if (!strncmp("goto ", command_mode_command.command, 5)) {
+		UserCommandDataOffset* data = (UserCommandDataOffset*)malloc(sizeof(UserCommandDataOffset));
+		data->offset = strtoull(command_mode_command.command + 5, NULL, 0);
+
+		return add_user_command(read_index, write_index, UC_GOTO, normal_mode_command.count, (char*)data);
+	}
+
+	if (!strcmp("wa", command_mode_command.command))
+		return add_user_command_with_no_data(read_index, write_index, UC_SAVE_ALL, normal_mode_command.count);
+
+	if (!strcmp("bn", command_mode_command.command) || !strcmp("bnext", command_mode_command.command))
+		return add_user_command_with_no_data(read_index, write_index, UC_BUFFER_NEXT, normal_mode_command.count);
+
+	if (!strcmp("bp", command_mode_command.command) || !strcmp("bprevious", command_mode_command.command))
+		return add_user_command_with_no_data(read_index, write_index, UC_BUFFER_PREV, normal_mode_command.count);
+
+	if (!strcmp("follow", command_mode_command.command))
+		return add_user_command_with_no_data(read_index, write_index, UC_FOLLOW, normal_mode_command.count);
+
+	if (!strcmp("set wrap", command_mode_command.command))
+		return add_user_command_with_no_data(read_index, write_index, UC_SET_WRAP, normal_mode_command.count);
+
+	if (!strcmp("set nowrap", command_mode_command.command))
+		return add_user_command_with_no_data(read_index, write_index, UC_SET_NOWRAP, normal_mode_command.count);
+
 	if (!strcmp("wq", command_mode_command.command)) {
 		add_user_command_with_no_data(read_index, write_index, UC_SAVE_FILE, normal_mode_command.count);
 		return add_user_command_with_no_data(read_index, write_index, UC_QUIT, normal_mode_command.count);
@@ -1358,72 +3077,63 @@ void handle_insert_mode_command(int* read_index, int* write_index) {
 	);
 }
 
-bool handle_user_input(char *input_buf, int *buffer_read_index, int *buffer_write_index) {
-	int k = b_read_input(input_buf);
+void handle_user_input_symbol(char symbol, int *buffer_read_index, int *buffer_write_index) {
+	if (symbol_is_escape(symbol)) {
+		add_user_command_with_no_data(buffer_read_index, buffer_write_index, UC_esc, 1);
 
-	if (k == 0)
-		return false;
+		return;
+	}
 
-	for (int i = 0; i < k; i++) {
-		if (symbol_is_escape(input_buf[i])) {
-			add_user_command_with_no_data(buffer_read_index, buffer_write_index, UC_esc, 1);
+	if (mode_type == MODE_NORMAL) {
+		switch (symbol) {
+			case '0':
+			case '1':
+			case '2':
+			case '3':
+			case '4':
+			case '5':
+			case '6':
+			case '7':
+			case '8':
+			case '9':
+				normal_mode_command_add_count(symbol - '0');
+				break;
 
-			continue;
+			default:
+				normal_mode_command_add_char(symbol);
+				break;
 		}
 
-		if (mode_type == MODE_NORMAL) {
-			switch (input_buf[i]) {
-				case '0':
-				case '1':
-				case '2':
-				case '3':
-				case '4':
-				case '5':
-				case '6':
-				case '7':
-				case '8':
-				case '9':
-					normal_mode_command_add_count(input_buf[i] - '0');
-					break;
+		if (!normal_mode_command_is_valid_partial())
+			normal_mode_command_clear();
 
-				default:
-					normal_mode_command_add_char(input_buf[i]);
-					break;
-			}
-
-			if (!normal_mode_command_is_valid_partial())
-				normal_mode_command_clear();
+		if (normal_mode_command.command[0] != 0 && normal_mode_command_is_valid_full()) {
+			handle_normal_mode_command(buffer_read_index, buffer_write_index);
+			normal_mode_command_clear();
+		}
+	} else if (mode_type == MODE_COMMAND) {
+		if (symbol_is_enter(symbol)) {
+			if (command_mode_command_is_valid()) {
+				handle_command_mode_command(buffer_read_index, buffer_write_index);
+			} else {
+				char error_text[MAX_COMMAND_SIZE] = {0};
+				sprintf(error_text, "Not and editor command: %s", command_mode_command.command);
 
-			if (normal_mode_command_is_valid_full()) {
-				handle_normal_mode_command(buffer_read_index, buffer_write_index);
-				normal_mode_command_clear();
+				message_set(error_text);
 			}
-		} else if (mode_type == MODE_COMMAND) {
-			if (symbol_is_enter(input_buf[i])) {
-				if (command_mode_command_is_valid()) {
-					handle_command_mode_command(buffer_read_index, buffer_write_index);
-				} else {
-					char error_text[MAX_COMMAND_SIZE] = {0};
-					sprintf(error_text, "Not and editor command: %s", command_mode_command.command);
-
-					message_set(error_text);
-				}
 
-				command_mode_command_clear();
-				mode_set_type(MODE_NORMAL);
-			} else if (symbol_is_backspace(input_buf[i])) {
-				command_mode_strip_tail();
-			} else if (symbol_is_printable(input_buf[i])) {
-				command_mode_add_char(input_buf[i]);
-			}
-		} else if (mode_type == MODE_INSERT) {
-			insert_mode_command_add_char(input_buf[i]);
-			handle_insert_mode_command(buffer_read_index, buffer_write_index);
-			insert_mode_command_clear();
+			command_mode_command_clear();
+			mode_set_type(MODE_NORMAL);
+		} else if (symbol_is_backspace(symbol)) {
+			command_mode_strip_tail();
+		} else if (symbol_is_printable(symbol)) {
+			command_mode_add_char(symbol);
 		}
+	} else if (mode_type == MODE_INSERT) {
+		insert_mode_command_add_char(symbol);
+		handle_insert_mode_command(buffer_read_index, buffer_write_index);
+		insert_mode_command_clear();
 	}
-
-	return true;
 }
 
 void editor_command_add(
@@ -1466,6 +3176,12 @@ void editor_command_add_scroll(int* read_index, int* write_index, EditorScrollDi
 	editor_command_add(read_index, write_index, EC_SCROLL, &data, sizeof(data));
 }
 
+void editor_command_add_scroll_horizontal(int* read_index, int* write_index, EditorScrollHorizontalDirection direction, int count) {
+	EditorCommandScrollHorizontalData data = {.direction = direction, .scroll = count};
+
+	editor_command_add(read_index, write_index, EC_SCROLL_HORIZONTAL, &data, sizeof(data));
+}
+
 void editor_command_add_insert_symbol(int* read_index, int* write_index, char symbol, int count) {
 	EditorCommandInsertSymbolData data = {.symbol = symbol, .count = count};
 
@@ -1563,6 +3279,26 @@ void process_user_commands(
 				break;
 			}
 
+			case UC_zl: {
+				editor_command_add_scroll_horizontal(editor_read_index, editor_write_index, ED_SCROLL_RIGHT, cmd.count);
+				break;
+			}
+
+			case UC_zh: {
+				editor_command_add_scroll_horizontal(editor_read_index, editor_write_index, ED_SCROLL_LEFT, cmd.count);
+				break;
+			}
+
+			case UC_zs: {
+				editor_command_add_scroll_horizontal(editor_read_index, editor_write_index, ED_SCROLL_CURSOR_START, cmd.count);
+				break;
+			}
+
+			case UC_ze: {
+				editor_command_add_scroll_horizontal(editor_read_index, editor_write_index, ED_SCROLL_CURSOR_END, cmd.count);
+				break;
+			}
+
 			case UC_esc: {
 				normal_mode_command_clear();
 				insert_mode_command_clear();
@@ -1618,29 +3354,295 @@ void process_user_commands(
 				break;
 			}
 
-			case UC_CTRL_w_j: {
-				editor_command_add_switch_window(editor_read_index, editor_write_index, ED_SWITCH_WINDOW_DOWN, cmd.count);
-				break;
-			}
+			case UC_CTRL_w_j: {
+				editor_command_add_switch_window(editor_read_index, editor_write_index, ED_SWITCH_WINDOW_DOWN, cmd.count);
+				break;
+			}
+
+			case UC_CTRL_w_k: {
+				editor_command_add_switch_window(editor_read_index, editor_write_index, ED_SWITCH_WINDOW_UP, cmd.count);
+				break;
+			}
+
+			case UC_SAVE_FILE: {
+				editor_command_add(editor_read_index, editor_write_index, EC_SAVE_FILE, NULL, 0);
+				break;
+			}
+
+			case UC_FOLLOW: {
+				editor_command_add(editor_read_index, editor_write_index, EC_FOLLOW, NULL, 0);
+				break;
+			}
+
+			case UC_SET_WRAP: {
+				editor_config_set_wrap(true);
+				editor_command_add_normalize_cursor(editor_read_index, editor_write_index);
+				break;
+			}
+
+			case UC_SET_NOWRAP: {
+				editor_config_set_wrap(false);
+				editor_command_add_normalize_cursor(editor_read_index, editor_write_index);
+				break;
+			}
+
+			case UC_SAVE_ALL: {
+				editor_command_add(editor_read_index, editor_write_index, EC_SAVE_ALL, NULL, 0);
+				break;
+			}
+
+			case UC_BUFFER_NEXT: {
+				EditorCommandSwitchBufferData data = {.direction = MAX(1, cmd.count)};
+
+				editor_command_add(editor_read_index, editor_write_index, EC_SWITCH_BUFFER, &data, sizeof(EditorCommandSwitchBufferData));
+				break;
+			}
+
+			case UC_BUFFER_PREV: {
+				EditorCommandSwitchBufferData data = {.direction = -MAX(1, cmd.count)};
+
+				editor_command_add(editor_read_index, editor_write_index, EC_SWITCH_BUFFER, &data, sizeof(EditorCommandSwitchBufferData));
+				break;
+			}
+
+			case UC_GOTO: {
+				UserCommandDataOffset* data = (UserCommandDataOffset*)cmd.data;
+				EditorCommandGotoData goto_data = {.offset = data->offset};
+
+				editor_command_add(editor_read_index, editor_write_index, EC_GOTO, &goto_data, sizeof(EditorCommandGotoData));
+				break;
+			}
+
+			case UC_QUIT: {
+				editor_command_add(editor_read_index, editor_write_index, EC_QUIT, NULL, 0);
+				break;
+			}
+		}
+
+		*user_read_index = *user_read_index + 1;
+	}
+
+	*user_read_index = 0;
+	*user_write_index = 0;
+}
+
+void editor_window_hex_goto(EditorWindow* window, int64_t offset) {
+	HexT* hex = window->editor_buffer->hex;
+	int rows = view_rows(window->source_view);
+
+	window->hex_nibble = 0;
+
+	if (hex->size == 0)
+		return;
+
+	offset = MAX(0, MIN(offset, (int64_t)hex->size - 1));
+
+	int row = offset / HEX_BYTES_PER_ROW;
+
+	if (row < window->y_offset || row >= window->y_offset + rows)
+		window->y_offset = MAX(0, row - rows / 2);
+
+	window->cursor_pos.y = row - window->y_offset;
+	window->cursor_pos.x = offset % HEX_BYTES_PER_ROW;
+}
+
+int hex_digit_value(char symbol) {
+	if (symbol >= '0' && symbol <= '9')
+		return symbol - '0';
+
+	if (symbol >= 'a' && symbol <= 'f')
+		return symbol - 'a' + 10;
+
+	if (symbol >= 'A' && symbol <= 'F')
+		return symbol - 'A' + 10;
+
+	return -1;
+}
+
+void editor_window_hex_insert_symbol(EditorWindow* window, char symbol) {
+	EditorBufferT* buffer = window->editor_buffer;
+	HexT* hex = buffer->hex;
+	int64_t offset = editor_window_hex_offset(window);
+
+	if (symbol_is_backspace(symbol)) {
+		if (window->hex_nibble == 1) {
+			window->hex_nibble = 0;
+		} else if (offset > 0) {
+			editor_window_hex_goto(window, offset - 1);
+			window->hex_nibble = 1;
+		}
+
+		return;
+	}
+
+	int value = hex_digit_value(symbol);
+
+	if (value < 0 || offset >= hex->size)
+		return;
+
+	uint8_t byte = hex->data[offset];
+
+	if (window->hex_nibble == 0)
+		byte = (byte & 0x0f) | (value << 4);
+	else
+		byte = (byte & 0xf0) | value;
+
+	hex_set_byte(hex, offset, byte);
+
+	if (hex->dirty_count > 0)
+		editor_buffer_touch(buffer, NULL);
+
+	if (window->hex_nibble == 0) {
+		window->hex_nibble = 1;
+	} else if (offset + 1 < hex->size) {
+		editor_window_hex_goto(window, offset + 1);
+	}
+}
+
+void editor_buffer_hex_save(EditorBufferT* buffer) {
+	char message[MAX_MESSAGE_SIZE] = {0};
+	size_t pages_written;
+	int error = hex_save(buffer->hex, &pages_written);
+
+	if (error != 0) {
+		snprintf(message, MAX_MESSAGE_SIZE, "E: can't write \"%s\": %s", buffer->filename, strerror(error));
+	} else {
+		buffer->modified = false;
+		editor_buffer_mark_loaded(buffer);
+
+		snprintf(message, MAX_MESSAGE_SIZE, "\"%s\" %zu pages patched", buffer->filename, pages_written);
+	}
+
+	message_set(message);
+}
+
+bool editor_window_hex_process_command(EditorWindow* window, EditorCommand* command) {
+	int64_t offset = editor_window_hex_offset(window);
+	int64_t row_offset = offset - window->cursor_pos.x;
+	int64_t size = window->editor_buffer->hex->size;
+	int rows = view_rows(window->source_view);
+
+	switch (command->type) {
+		case EC_MOVE_CURSOR: {
+			EditorCommandMoveCursorData data;
+			memcpy(&data, &command->data, sizeof(EditorCommandMoveCursorData));
+
+			int move_count = MAX(1, data.count);
+			int64_t group = HEX_BYTES_PER_ROW / 2;
+
+			switch (data.direction) {
+				case ED_CURSOR_BACKWARD: offset -= move_count; break;
+				case ED_CURSOR_FORWARD: offset += move_count; break;
+				case ED_CURSOR_DOWN: offset += (int64_t)move_count * HEX_BYTES_PER_ROW; break;
+				case ED_CURSOR_UP: offset -= (int64_t)move_count * HEX_BYTES_PER_ROW; break;
+				case ED_CURSOR_TO_START_OF_LINE: offset = row_offset; break;
+				case ED_CURSOR_TO_END_OF_LINE: offset = row_offset + HEX_BYTES_PER_ROW - 1; break;
+				case ED_CURSOR_TOP: offset -= (int64_t)window->cursor_pos.y * HEX_BYTES_PER_ROW; break;
+				case ED_CURSOR_MID: offset += (int64_t)(rows / 2 - window->cursor_pos.y) * HEX_BYTES_PER_ROW; break;
+				case ED_CURSOR_BOTTOM: offset += (int64_t)(rows - 1 - window->cursor_pos.y) * HEX_BYTES_PER_ROW; break;
+				case ED_CURSOR_TO_NEXT_WORD: offset = (offset / group + move_count) * group; break;
+				case ED_CURSOR_TO_END_OF_WORD: offset = (offset / group + move_count) * group - 1; break;
+				case ED_CURSOR_TO_PREV_WORD: offset = ((offset - 1) / group - (move_count - 1)) * group; break;
+				case ED_CURSOR_TO_FIRST_LINE: offset = (int64_t)MAX(0, data.count - 1) * HEX_BYTES_PER_ROW; break;
+
+				case ED_CURSOR_TO_LAST_LINE: {
+					if (data.count == 0)
+						offset = size - 1;
+					else
+						offset = (int64_t)(data.count - 1) * HEX_BYTES_PER_ROW;
+
+					break;
+				}
+			}
+
+			if ((data.direction == ED_CURSOR_UP || data.direction == ED_CURSOR_TOP) && offset < 0)
+				offset += ((-offset + HEX_BYTES_PER_ROW - 1) / HEX_BYTES_PER_ROW) * HEX_BYTES_PER_ROW;
+
+			if ((data.direction == ED_CURSOR_DOWN || data.direction == ED_CURSOR_BOTTOM) && offset >= size)
+				offset -= ((offset - size) / HEX_BYTES_PER_ROW + 1) * HEX_BYTES_PER_ROW;
+
+			editor_window_hex_goto(window, offset);
+
+			return true;
+		}
+
+		case EC_SCROLL: {
+			EditorCommandScrollData data;
+			memcpy(&data, &command->data, sizeof(EditorCommandScrollData));
+
+			if (data.scroll > 0)
+				editor_config_set_scroll(data.scroll);
+
+			int64_t scroll = (int64_t)editor_config.scroll * HEX_BYTES_PER_ROW;
+
+			if (data.direction == ED_SCROLL_DOWN) {
+				window->y_offset = MAX(0, MIN(window->y_offset + editor_config.scroll, window->editor_buffer->lines_count - rows));
+				editor_window_hex_goto(window, MIN(offset + scroll, size - 1));
+			} else {
+				window->y_offset = MAX(0, window->y_offset - editor_config.scroll);
+				editor_window_hex_goto(window, offset - scroll);
+			}
+
+			return true;
+		}
+
+		case EC_NORMALIZE_CURSOR:
+		case EC_SCROLL_HORIZONTAL:
+			return true;
+
+		case EC_INSERT: {
+			EditorCommandInsertSymbolData data;
+			memcpy(&data, &command->data, sizeof(EditorCommandInsertSymbolData));
+
+			editor_window_hex_insert_symbol(window, data.symbol);
+
+			return true;
+		}
+
+		case EC_SAVE_FILE: {
+			editor_buffer_hex_save(window->editor_buffer);
+
+			return true;
+		}
+
+		case EC_FOLLOW: {
+			message_set("E: can't follow a hex buffer");
+
+			return true;
+		}
+
+		case EC_GOTO: {
+			EditorCommandGotoData data;
+			memcpy(&data, &command->data, sizeof(EditorCommandGotoData));
+
+			editor_window_hex_goto(window, (int64_t)MIN(data.offset, (uint64_t)INT64_MAX));
+
+			return true;
+		}
+
+		default:
+			return false;
+	}
+}
 
-			case UC_CTRL_w_k: {
-				editor_command_add_switch_window(editor_read_index, editor_write_index, ED_SWITCH_WINDOW_UP, cmd.count);
-				break;
-			}
+void editor_buffers_write_all() {
+	int submitted = 0;
 
-			case UC_SAVE_FILE: {
-				editor_command_add(editor_read_index, editor_write_index, EC_SAVE_FILE, NULL, 0);
-				break;
-			}
+	for (EditorBufferT* buffer = buffers; buffer != NULL; buffer = buffer->next) {
+		if (!buffer->modified)
+			continue;
 
-			case UC_QUIT: {
-				editor_command_add(editor_read_index, editor_write_index, EC_QUIT, NULL, 0);
-				break;
-			}
+		if (buffer->hex != NULL) {
+			editor_buffer_hex_save(buffer);
+		} else {
+			write_buffer_into_file(buffer, &save_batch);
 		}
 
-		*user_read_index = *user_read_index + 1;
+		submitted++;
 	}
+
+	if (submitted == 0)
+		message_set("No modified buffers");
 }
 
 void process_editor_commands(
@@ -1653,9 +3655,16 @@ void process_editor_commands(
 	Pos* cursor_pos = &editor_window->cursor_pos;
 	int cols = view_cols(editor_window->source_view);
 	int rows = view_rows(editor_window->source_view);
-	int total_rows = line_count_from(editor_window->editor_buffer->head_line);
+	int total_rows = editor_window->editor_buffer->lines_count;
 
 	while (*editor_read_index != *editor_write_index) {
+		if (editor_window->editor_buffer->hex != NULL &&
+				editor_window_hex_process_command(editor_window, &editor_commands[*editor_read_index])) {
+			*editor_read_index = *editor_read_index + 1;
+
+			continue;
+		}
+
 		switch (editor_commands[*editor_read_index].type) {
 			case EC_MOVE_CURSOR: {
 				EditorCommandMoveCursorData data;
@@ -1709,7 +3718,7 @@ void process_editor_commands(
 
 					case ED_CURSOR_MID: {
 						int current_row = cursor_pos->y;
-						int lines_offset = (rows / 2) - current_row;
+						int lines_offset = (editor_window_visible_lines(editor_window, rows) / 2) - current_row;
 
 						nav_vertical(cursor_line, cursor_line_item, cursor_pos, lines_offset);
 
@@ -1717,7 +3726,7 @@ void process_editor_commands(
 					}
 
 					case ED_CURSOR_BOTTOM: {
-						nav_down(cursor_line, cursor_line_item, cursor_pos, rows - cursor_pos->y - 1);
+						nav_down(cursor_line, cursor_line_item, cursor_pos, editor_window_visible_lines(editor_window, rows) - cursor_pos->y - 1);
 
 						break;
 					}
@@ -1794,8 +3803,6 @@ void process_editor_commands(
 				EditorCommandSwitchWindowData data;
 				memcpy(&data, &editor_commands[*editor_read_index].data, sizeof(EditorCommandSwitchWindowData));
 
-				int move_count = MAX(1, data.count);
-
 				switch (data.direction) {
 					case ED_SWITCH_WINDOW_RIGHT: {
 						if (current_editor_tab->tab_item_current->right != NULL) {
@@ -1844,8 +3851,6 @@ void process_editor_commands(
 				EditorCommandScrollData data;
 				memcpy(&data, &editor_commands[*editor_read_index].data, sizeof(EditorCommandScrollData));
 
-				int move_count = MAX(1, data.scroll);
-
 				if (data.scroll > 0)
 					editor_config_set_scroll(data.scroll);
 
@@ -1870,110 +3875,338 @@ void process_editor_commands(
 				break;
 			}
 
-			case EC_INSERT: {
-				EditorCommandInsertSymbolData data;
-				memcpy(&data, &editor_commands[*editor_read_index].data, sizeof(EditorCommandInsertSymbolData));
+			case EC_SCROLL_HORIZONTAL: {
+				EditorCommandScrollHorizontalData data;
+				memcpy(&data, &editor_commands[*editor_read_index].data, sizeof(EditorCommandScrollHorizontalData));
 
-				if (symbol_is_backspace(data.symbol)) {
-					int shift = insert_delete_symbol(cursor_line, cursor_line_item);
-					cursor_backward(cursor_pos, shift);
+				int move_count = MAX(1, data.scroll);
 
-					if (shift == 0 && editor_window->cursor_line->prev != NULL) {
-						if (line_item_is_newline(editor_window->cursor_line->prev->item_head)) {
-							line_delete_before(*cursor_line);
-							cursor_up(cursor_pos, 1);
-						} else {
-							nav_up(cursor_line, cursor_line_item, cursor_pos, 1);
-							nav_to_end_of_line(cursor_line_item, cursor_pos);
-							nav_backward(cursor_line_item, cursor_pos);
-							line_concat_after(*cursor_line);
-							cursor_forward(cursor_pos, 1);
-							line_item_next(cursor_line_item);
+				switch (data.direction) {
+					case ED_SCROLL_RIGHT: {
+						editor_window->x_offset += move_count;
+
+						while (cursor_pos->x < editor_window->x_offset && !line_item_is_newline(*cursor_line_item)) {
+							if (!nav_forward(cursor_line_item, cursor_pos))
+								break;
 						}
+
+						if (line_item_is_newline(*cursor_line_item))
+							nav_backward(cursor_line_item, cursor_pos);
+
+						break;
 					}
-				} else if (symbol_is_enter(data.symbol)) {
-					LineT* current_line = *cursor_line;
-					LineItemT* line_tail = *cursor_line_item;
-					LineItemT* new_end_of_current_line = line_tail->prev;
 
-					line_new_after(cursor_line);
-					nav_down(cursor_line, cursor_line_item, cursor_pos, 1);
+					case ED_SCROLL_LEFT: {
+						editor_window->x_offset = MAX(0, editor_window->x_offset - move_count);
+
+						while (cursor_pos->x >= editor_window->x_offset + cols) {
+							if (!nav_backward(cursor_line_item, cursor_pos))
+								break;
+						}
 
-					LineItemT* new_line_terminator = line_find_next_symbol(*cursor_line, '\n');
+						break;
+					}
 
-					line_set_head(*cursor_line, line_tail);
+					case ED_SCROLL_CURSOR_START: {
+						editor_window->x_offset = cursor_pos->x;
 
-					if (new_end_of_current_line != NULL) {
-						new_end_of_current_line->next = new_line_terminator;
-						new_line_terminator->prev = new_end_of_current_line;
-					} else {
-						current_line->item_head = new_line_terminator;
+						break;
 					}
 
-					*cursor_line_item = (*cursor_line)->item_head;
-				} else if (symbol_is_printable(data.symbol)) {
-					int shift = insert_insert_symbol(editor_window->cursor_line, editor_window->cursor_line_item, data.symbol);
-					cursor_forward(cursor_pos, shift);
+					case ED_SCROLL_CURSOR_END: {
+						editor_window->x_offset = MAX(0, cursor_pos->x - cols + 1);
+
+						break;
+					}
 				}
 
 				break;
 			}
 
+			case EC_INSERT: {
+				EditorCommandInsertSymbolData data;
+				memcpy(&data, &editor_commands[*editor_read_index].data, sizeof(EditorCommandInsertSymbolData));
+
+				if (editor_window->editor_buffer->loading)
+					break;
+
+				editor_buffer_journal_insert(editor_window, data.symbol);
+				editor_window_insert_symbol(editor_window, data.symbol);
+
+				break;
+			}
+
 			case EC_SAVE_FILE: {
-				write_buffer_into_file(editor_window->editor_buffer);
+				write_buffer_into_file(editor_window->editor_buffer, NULL);
+				break;
+			}
+
+			case EC_FOLLOW: {
+				editor_buffer_set_follow(editor_window->editor_buffer, !editor_window->editor_buffer->follow);
+				break;
+			}
+
+			case EC_GOTO: {
+				message_set("E: :goto is only supported in hex view");
+				break;
+			}
+
+			case EC_SWITCH_BUFFER: {
+				EditorCommandSwitchBufferData data;
+				memcpy(&data, &editor_commands[*editor_read_index].data, sizeof(EditorCommandSwitchBufferData));
+
+				editor_window_switch_buffer(editor_window, data.direction);
+				break;
+			}
+
+			case EC_SAVE_ALL: {
+				editor_buffers_write_all();
 				break;
 			}
 
 			case EC_QUIT: {
-				s_exit_editor();
+				io_wait_idle();
+
+				if (process_io_results() == 0) {
+					editor_buffers_close_journals(true);
+					s_exit_editor();
+				}
+
 				break;
 			}
 		}
 
-
+		editor_window_sync_cursor(editor_window, rows, cols);
 
 		*editor_read_index = *editor_read_index + 1;
 	}
+
+	*editor_read_index = 0;
+	*editor_write_index = 0;
 }
 
-EditorTabItemT* init_editor_tab_item(
-	char* filename,
-	ViewT* parent_view
+bool handle_user_input(
+	char* input_buf,
+	size_t input_buf_size,
+	int* user_read_index,
+	int* user_write_index,
+	int* editor_read_index,
+	int* editor_write_index
+) {
+	int k = b_read_input(input_buf, input_buf_size);
+
+	if (k == 0 || (k < 0 && errno != EINTR && errno != EAGAIN))
+		b_input_eof = true;
+
+	if (k <= 0)
+		return false;
+
+	for (int i = 0; i < k && !exit_loop; i++) {
+		if (journal_prompt_buffer != NULL) {
+			editor_buffer_answer_journal(input_buf[i]);
+
+			continue;
+		}
+
+		handle_user_input_symbol(input_buf[i], user_read_index, user_write_index);
+
+		process_user_commands(
+			user_read_index,
+			user_write_index,
+			editor_read_index,
+			editor_write_index,
+			&normal_mode_command
+		);
+
+		process_editor_commands(
+			editor_read_index,
+			editor_write_index,
+			current_editor_tab->tab_item_current->window
+		);
+	}
+
+	return true;
+}
+
+int drain_user_input(
+	char* input_buf,
+	size_t input_buf_size,
+	int* user_read_index,
+	int* user_write_index,
+	int* editor_read_index,
+	int* editor_write_index
 ) {
+	int64_t started_ms = clock_ms();
+	int reads = 0;
+
+	if (editor_config.frame_per_key)
+		input_buf_size = 1;
+
+	do {
+		if (!handle_user_input(input_buf, input_buf_size, user_read_index, user_write_index, editor_read_index, editor_write_index))
+			break;
+
+		reads++;
+	} while (!exit_loop && !editor_config.frame_per_key && clock_ms() - started_ms < BACKGROUND_FRAME_INTERVAL_MS && b_input_pending());
+
+	return reads;
+}
+
+void editor_render_frame(ViewT* command_line_view, ViewT* debug_info_view, DebugInformation debug_info, int rows, int cols) {
+	int64_t started_ns = clock_ns();
+
+	draw_editor_tab(current_editor_tab);
+	draw_command_line(command_line_view);
+	draw_debug_information(debug_info_view, debug_info);
+
+	t_render(rows, cols);
+	switch_grids();
+
+	editor_frame_stats.render_ns += clock_ns() - started_ns;
+	editor_frame_stats.rendered++;
+}
+
+bool parse_terminal_size(char* text, int* cols, int* rows) {
+	char* end = NULL;
+	long parsed_cols = strtol(text, &end, 10);
+
+	if (end == text || *end != 'x')
+		return false;
+
+	char* rows_text = end + 1;
+	long parsed_rows = strtol(rows_text, &end, 10);
+
+	if (end == rows_text || *end != 0 || parsed_cols <= 0 || parsed_rows <= COMMAND_LINE_HEIGHT || parsed_cols > 10000 || parsed_rows > 10000)
+		return false;
+
+	*cols = parsed_cols;
+	*rows = parsed_rows;
+
+	return true;
+}
+
+int editor_frame_interval_ms(bool user_input) {
+	int interval = editor_config.max_fps > 0 ? 1000 / editor_config.max_fps : 0;
+
+	if (user_input)
+		return interval;
+
+	return MAX(interval, BACKGROUND_FRAME_INTERVAL_MS);
+}
+
+void editor_window_layout_views(EditorWindow* window, ViewT* parent_view) {
 	int parent_view_cols = view_cols(parent_view);
 	int parent_view_rows = view_rows(parent_view);
 
-	ViewT* source_view = view_new(STATUS_COLUMN_WIDTH, 0, parent_view_cols, parent_view_rows - INFO_LINE_HEIGHT, parent_view);
-	ViewT* status_column_view = view_new(0, 0, STATUS_COLUMN_WIDTH, parent_view_rows - INFO_LINE_HEIGHT, parent_view);
-	ViewT* info_line_view = view_new(0, parent_view_rows - INFO_LINE_HEIGHT, parent_view_cols, parent_view_rows, parent_view);
+	view_resize(window->source_view, STATUS_COLUMN_WIDTH, 0, parent_view_cols, parent_view_rows - INFO_LINE_HEIGHT);
+	view_resize(window->status_column_view, 0, 0, STATUS_COLUMN_WIDTH, parent_view_rows - INFO_LINE_HEIGHT);
+	view_resize(window->info_line_view, 0, parent_view_rows - INFO_LINE_HEIGHT, parent_view_cols, parent_view_rows);
+}
 
-	EditorBufferT* editor_buffer = editor_buffer_find_by_filename(filename);
+void editor_window_layout(EditorWindow* window) {
+	editor_window_layout_views(window, window->source_view->parent);
 
-	if (editor_buffer == NULL) {
-		editor_buffer = editor_buffer_new();
+	window->drawn_y_offset = window->y_offset;
 
-		if (strcmp("", filename)) {
-			editor_buffer->head_line = read_and_parse_source_file(filename);
-			editor_buffer->filename = filename;
-		} else {
-			LineItemT* head_line_item = line_item_new('\n');
+	if (window->editor_buffer->hex != NULL) {
+		editor_window_hex_goto(window, editor_window_hex_offset(window));
 
-			editor_buffer->head_line = line_new(head_line_item);
-			editor_buffer->filename = "";
-		}
+		return;
 	}
 
+	int rows = view_rows(window->source_view);
+
+	offset_sync_with_cursor(&window->y_offset, &window->cursor_pos, rows, window->editor_buffer->lines_count);
+	editor_window_sync_cursor(window, rows, view_cols(window->source_view));
+}
+
+void editor_tab_item_layout(EditorTabItemT* editor_tab_item) {
+	if (editor_tab_item == NULL)
+		return;
+
+	editor_window_layout(editor_tab_item->window);
+
+	editor_tab_item_layout(editor_tab_item->right);
+	editor_tab_item_layout(editor_tab_item->down);
+}
+
+void editor_layout_views(EditorLayoutT* layout, int rows, int cols) {
+	view_resize(layout->main_view, 0, 0, cols, rows);
+	view_resize(layout->source_view, 0, 0, cols, rows - COMMAND_LINE_HEIGHT);
+	view_resize_embedded(layout->editor_tab_view);
+	view_resize(layout->command_line_view, 0, rows - COMMAND_LINE_HEIGHT, cols, rows);
+	view_resize(layout->debug_info_view, (cols / 3) * 2, 0, cols - 1, (rows / 3) * 2);
+}
+
+EditorLayoutT editor_layout_new(int rows, int cols) {
+	EditorLayoutT layout;
+
+	layout.main_view = view_new(0, 0, 0, 0, NULL);
+	layout.source_view = view_new(0, 0, 0, 0, layout.main_view);
+	layout.editor_tab_view = view_new_embedded(layout.source_view);
+	layout.command_line_view = view_new(0, 0, 0, 0, layout.main_view);
+	layout.debug_info_view = view_new(0, 0, 0, 0, layout.main_view);
+
+	editor_layout_views(&layout, rows, cols);
+
+	return layout;
+}
+
+bool editor_terminal_size(int* rows, int* cols) {
+	struct winsize w_winsize = {};
+
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w_winsize) < 0 || w_winsize.ws_row == 0 || w_winsize.ws_col == 0)
+		return false;
+
+	*rows = MAX(w_winsize.ws_row, COMMAND_LINE_HEIGHT + INFO_LINE_HEIGHT + 1);
+	*cols = MAX(w_winsize.ws_col, STATUS_COLUMN_WIDTH + 1);
+
+	return true;
+}
+
+void editor_resize(EditorLayoutT* layout, int rows, int cols) {
+	editor_layout_views(layout, rows, cols);
+
+	EditorTabT* editor_tab = current_editor_tab;
+
+	while (editor_tab->prev != NULL)
+		editor_tab = editor_tab->prev;
+
+	for (; editor_tab != NULL; editor_tab = editor_tab->next)
+		editor_tab_item_layout(editor_tab->tab_item_head);
+
+	editor_config_set_scroll(rows / 2);
+
+	t_grids_init(rows, cols);
+	t_clear_screen();
+	t_invalidate();
+}
+
+EditorTabItemT* init_editor_tab_item(
+	char* filename,
+	ViewT* parent_view
+) {
+	EditorBufferT* editor_buffer = editor_buffer_open(filename);
+
 	EditorWindow* editor_window = editor_window_new();
 	editor_window->editor_buffer = editor_buffer;
 	editor_window->cursor_line = editor_buffer->head_line;
 	editor_window->cursor_line_item = editor_buffer->head_line->item_head;
-	editor_window->source_view = source_view;
-	editor_window->status_column_view = status_column_view;
-	editor_window->info_line_view = info_line_view;
+	editor_window->source_view = view_new(0, 0, 0, 0, parent_view);
+	editor_window->status_column_view = view_new(0, 0, 0, 0, parent_view);
+	editor_window->info_line_view = view_new(0, 0, 0, 0, parent_view);
+	editor_window_layout_views(editor_window, parent_view);
 	editor_window->cursor_pos.x = 0;
 	editor_window->cursor_pos.y = 0;
 	editor_window->x_offset = 0;
 	editor_window->y_offset = 0;
+	editor_window->top_line_id = 0;
+	editor_window->top_line_row = 0;
+	editor_window->pinned = false;
+	editor_window->hex_nibble = 0;
+	editor_window->drawn_y_offset = 0;
+	memset(&editor_window->drawn_status_column, 0, sizeof(EditorStatusColumnState));
+	memset(&editor_window->drawn_info_line, 0, sizeof(EditorInfoLineState));
 
 	EditorTabItemT* editor_tab_item = editor_tab_item_new();
 	editor_tab_item->tabno = tabno_counter;
@@ -1997,26 +4230,119 @@ EditorTabT* init_editor_tab(
 	return editor_tab;
 }
 
+#ifndef NG_NO_MAIN
 int main(int argc, char * argv[]) {
 	srand(time(NULL));
 
+	char* filename = "";
+	char** filenames = (char**)malloc(sizeof(char*) * argc);
+	int filenames_count = 0;
+	bool follow = false;
+	int rows = 0;
+	int cols = 0;
+	bool size_fixed = false;
+	int render_thread = -1;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp("-f", argv[i]))
+			follow = true;
+		else if (!strcmp("-x", argv[i]))
+			editor_config.hex = true;
+		else if (!strcmp("--max-fps", argv[i]) && i + 1 < argc)
+			editor_config.max_fps = atoi(argv[++i]);
+		else if (!strcmp("--frame-per-key", argv[i]))
+			editor_config.frame_per_key = true;
+		else if (!strcmp("--render-thread", argv[i]) && i + 1 < argc) {
+			char* mode = argv[++i];
+
+			if (!strcmp("on", mode)) {
+				render_thread = 1;
+			} else if (!strcmp("off", mode)) {
+				render_thread = 0;
+			} else {
+				fprintf(stderr, "ng-editor: unknown render thread mode \"%s\", expected on or off\n", mode);
+
+				return 1;
+			}
+		}
+		else if (!strcmp("--backend", argv[i]) && i + 1 < argc) {
+			char* backend = argv[++i];
+
+			if (!strcmp("terminal", backend)) {
+				t_backend_set(T_BACKEND_TERMINAL);
+			} else if (!strcmp("memory", backend)) {
+				t_backend_set(T_BACKEND_MEMORY);
+			} else if (!strcmp("null", backend)) {
+				t_backend_set(T_BACKEND_NULL);
+			} else {
+				fprintf(stderr, "ng-editor: unknown backend \"%s\", expected terminal, memory or null\n", backend);
+
+				return 1;
+			}
+		} else if (!strcmp("--size", argv[i]) && i + 1 < argc) {
+			if (!parse_terminal_size(argv[++i], &cols, &rows)) {
+				fprintf(stderr, "ng-editor: bad size \"%s\", expected COLSxROWS\n", argv[i]);
+
+				return 1;
+			}
+
+			size_fixed = true;
+		}
+		else
+			filenames[filenames_count++] = argv[i];
+	}
+
+	if (filenames_count > 0)
+		filename = filenames[0];
+
+	int stdin_filenames_count = 0;
+
+	for (int i = 0; i < filenames_count; i++) {
+		if (!strcmp("-", filenames[i]))
+			stdin_filenames_count++;
+	}
+
+	if (stdin_filenames_count > 1) {
+		fprintf(stderr, "ng-editor: stdin (\"-\") can be given only once\n");
+
+		return 1;
+	}
+
+	if (stdin_filenames_count > 0) {
+		t_input_fd = open("/dev/tty", O_RDONLY);
+
+		if (t_input_fd < 0) {
+			fprintf(stderr, "ng-editor: can't open /dev/tty for keyboard input\n");
+
+			return 1;
+		}
+	}
+
 	t_configure_terminal();
 	atexit(t_restore_terminal);
 	signal(SIGINT, s_exit_editor);
 
-	t_clear_screen();
+	if (!size_fixed)
+		resize_start();
 
-	struct winsize w_winsize;
-	ioctl(STDOUT_FILENO, TIOCGWINSZ, &w_winsize);
+	io_start();
+	watch_start();
 
-	int rows = w_winsize.ws_row;
-	int cols = w_winsize.ws_col;
+	t_clear_screen();
 
-	if (rows == 0)
+	if (!size_fixed && !editor_terminal_size(&rows, &cols)) {
 		rows = 80;
-
-	if (cols == 0)
 		cols = 190;
+	}
+
+	t_set_palette(editor_palette, sizeof(editor_palette) / sizeof(editor_palette[0]));
+	t_grids_init(rows, cols);
+
+	if (render_thread < 0)
+		render_thread = t_backend.type == T_BACKEND_TERMINAL;
+
+	if (render_thread)
+		t_render_thread_start();
 
 	int user_command_read_index = 0;
 	int user_command_write_index = 0;
@@ -2025,19 +4351,19 @@ int main(int argc, char * argv[]) {
 	int editor_command_write_index = 0;
 
 	char user_input_buf[256];
-	char* filename = "";
 
-	if (argc > 1)
-		filename = argv[1];
+	EditorLayoutT layout = editor_layout_new(rows, cols);
+
+	current_editor_tab = init_editor_tab(filename, layout.editor_tab_view);
 
-	ViewT* main_view = view_new(0, 0, cols, rows, NULL);
-	ViewT* source_view = view_new(0, 0, cols, rows - COMMAND_LINE_HEIGHT, main_view);
-	ViewT* current_editor_tab_view = view_new_embedded(source_view);
+	for (int i = 1; i < filenames_count; i++)
+		editor_buffer_open(filenames[i]);
 
-	current_editor_tab = init_editor_tab(filename, current_editor_tab_view);
+	editor_buffer_wait_loaded(current_editor_tab->tab_item_current->window->editor_buffer);
+	editor_buffer_offer_journal(current_editor_tab->tab_item_current->window->editor_buffer);
 
-	ViewT* command_line_view = view_new(0, rows - COMMAND_LINE_HEIGHT, cols, rows, main_view);
-	ViewT* debug_info_view = view_new((cols / 3) * 2, 0, cols - 1, (rows / 3) * 2, main_view);
+	if (follow)
+		editor_buffer_set_follow(current_editor_tab->tab_item_current->window->editor_buffer, true);
 
 	DebugInformation debug_info = {
 		.cols = &cols,
@@ -2046,38 +4372,135 @@ int main(int argc, char * argv[]) {
 
 	editor_config_set_scroll(rows / 2);
 
-	draw_editor_tab(current_editor_tab);
-	draw_command_line(command_line_view);
-	draw_debug_information(debug_info_view, debug_info);
+	editor_render_frame(layout.command_line_view, layout.debug_info_view, debug_info, rows, cols);
 
-	t_render(rows, cols);
-	switch_grids();
+	bool stream_pending = false;
+	int frames_pending = 0;
+	bool user_input = false;
+	int64_t resize_signaled_ns = 0;
+	int64_t last_frame_ms = clock_ms();
 
 	while (!exit_loop) {
-		if (!handle_user_input(user_input_buf, &user_command_read_index, &user_command_write_index))
+		int timeout = -1;
+
+		if (stream_pending)
+			timeout = 0;
+		else if (frames_pending > 0)
+			timeout = MAX(0, last_frame_ms + editor_frame_interval_ms(user_input) - clock_ms());
+
+		struct pollfd poll_fds[] = {
+			{.fd = t_input_fd, .events = POLLIN},
+			{.fd = io_notify_fd(), .events = POLLIN},
+			{.fd = watch_notify_fd(), .events = POLLIN},
+			{.fd = streaming_buffer != NULL ? stream_notify_fd(streaming_buffer->stream) : -1, .events = POLLIN},
+			{.fd = resize_notify_pipe[0], .events = POLLIN},
+		};
+
+		if (poll(poll_fds, 5, timeout) < 0)
 			continue;
 
-		process_user_commands(
-			&user_command_read_index,
-			&user_command_write_index,
-			&editor_command_read_index,
-			&editor_command_write_index,
-			&normal_mode_command
-		);
+		bool frame_requested = false;
 
-		process_editor_commands(
-			&editor_command_read_index,
-			&editor_command_write_index,
-			current_editor_tab->tab_item_current->window
-		);
+		if (poll_fds[4].revents & POLLIN) {
+			int64_t signaled_ns = resize_drain();
+			int new_rows = rows;
+			int new_cols = cols;
+
+			if (editor_terminal_size(&new_rows, &new_cols) && (new_rows != rows || new_cols != cols)) {
+				rows = new_rows;
+				cols = new_cols;
+
+				editor_resize(&layout, rows, cols);
+
+				if (resize_signaled_ns == 0)
+					resize_signaled_ns = signaled_ns;
+
+				frame_requested = true;
+			}
+		}
+
+		if ((poll_fds[3].revents & POLLIN) || stream_pending) {
+			stream_pending = process_stream_input();
+			frame_requested = true;
+		}
+
+		if (poll_fds[1].revents & POLLIN) {
+			process_io_results();
+			frame_requested = true;
+		}
+
+		if (poll_fds[2].revents & POLLIN) {
+			process_watch_events();
+			frame_requested = true;
+		}
+
+		if (poll_fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+			int reads = drain_user_input(
+				user_input_buf,
+				sizeof(user_input_buf),
+				&user_command_read_index,
+				&user_command_write_index,
+				&editor_command_read_index,
+				&editor_command_write_index
+			);
+
+			if (reads == 0) {
+				if (b_input_eof)
+					s_exit_editor();
+
+				continue;
+			}
+
+			frame_requested = true;
+			user_input = true;
+		}
+
+		if (frame_requested)
+			frames_pending++;
+
+		if (frames_pending == 0)
+			continue;
+
+		if (resize_signaled_ns == 0 && clock_ms() - last_frame_ms < editor_frame_interval_ms(user_input))
+			continue;
+
+		process_disk_changes();
+
+		editor_render_frame(layout.command_line_view, layout.debug_info_view, debug_info, rows, cols);
+
+		// Every wake-up that changed state asked for a frame, only the last one is drawn.
+		editor_frame_stats.skipped += frames_pending - 1;
 
-		draw_editor_tab(current_editor_tab);
-		draw_command_line(command_line_view);
-		draw_debug_information(debug_info_view, debug_info);
+		if (resize_signaled_ns != 0) {
+			editor_frame_stats.resizes++;
+			editor_frame_stats.resize_ns_last = clock_ns() - resize_signaled_ns;
+			editor_frame_stats.resize_ns_max = MAX(editor_frame_stats.resize_ns_max, editor_frame_stats.resize_ns_last);
+			resize_signaled_ns = 0;
+		}
+
+		last_frame_ms = clock_ms();
+		frames_pending = 0;
+		user_input = false;
+	}
 
-		t_render(rows, cols);
-		switch_grids();
+	io_wait_idle();
+	process_io_results();
+	editor_buffers_close_journals(false);
+	t_render_thread_stop();
+
+	if (t_backend.type != T_BACKEND_TERMINAL) {
+		fprintf(stderr, "%dx%d: %lu frames rendered, %lu skipped, %.0f ns/frame, %luB written\n",
+			cols, rows,
+			(unsigned long)editor_frame_stats.rendered,
+			(unsigned long)editor_frame_stats.skipped,
+			(double)editor_frame_stats.render_ns / MAX(1, editor_frame_stats.rendered),
+			(unsigned long)t_stats.bytes);
 	}
 
+	if (t_backend.type == T_BACKEND_MEMORY)
+		t_grid_dump(stdout);
+
 	t_move_cursor(0, rows);
+	t_frame_flush();
 }
+#endif
@@ -0,0 +1,176 @@
+#define NG_NO_MAIN
+
+#include "main.c"
+
+#define BENCH_FRAMES 2000
+#define BENCH_LEGACY_GRID_SIZE 1024
+
+double bench_now_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void bench_fill_grid(int rows, int cols) {
+	for (int y = 0; y < rows; y++) {
+		for (int x = 0; x < cols; x++) {
+			t_set_cell(x, y, 'a' + (x + y) % 26, CLEAR);
+		}
+	}
+}
+
+void bench_render(int rows, int cols) {
+	t_grids_init(rows, cols);
+	bench_fill_grid(rows, cols);
+
+	t_render(rows, cols);
+	switch_grids();
+
+	uint64_t bytes = 0;
+	uint64_t copied = 0;
+	uint64_t visited = 0;
+	double started = bench_now_ns();
+
+	for (int i = 0; i < BENCH_FRAMES; i++) {
+		int x = i % cols;
+		int y = (i / cols) % rows;
+		int prev_x = (i + cols - 1) % cols;
+		int prev_y = ((i + cols - 1) / cols - 1 + rows) % rows;
+
+		t_set_cell_style(prev_x, prev_y, CLEAR);
+		t_set_cell_style(x, y, CURSOR);
+
+		t_render(rows, cols);
+		switch_grids();
+
+		bytes += t_stats.frame_bytes;
+		copied += t_stats.grid_bytes_copied;
+		visited += t_stats.cells_visited;
+	}
+
+	double elapsed = bench_now_ns() - started;
+
+	fprintf(stderr, "%4dx%-4d cursor move: %9.0f ns/frame, %6.1f B written/frame, %8.1f B of grid copied/frame, %7.1f cells diffed/frame\n",
+		cols, rows,
+		elapsed / BENCH_FRAMES,
+		(double)bytes / BENCH_FRAMES,
+		(double)copied / BENCH_FRAMES,
+		(double)visited / BENCH_FRAMES);
+}
+
+void bench_scroll(int rows, int cols, bool hardware) {
+	t_grids_init(rows, cols);
+	bench_fill_grid(rows, cols);
+
+	t_render(rows, cols);
+	switch_grids();
+
+	uint64_t bytes = 0;
+	double started = bench_now_ns();
+
+	for (int i = 0; i < BENCH_FRAMES; i++) {
+		if (hardware)
+			t_scroll_rows(0, rows, 1);
+
+		for (int y = 0; y < rows; y++) {
+			int line = y + i;
+			int len = (line * 7) % (cols - 8);
+
+			for (int x = 0; x < cols; x++) {
+				Color color = y == rows / 2 ? HIGHLIGHT : CLEAR;
+				char symbol = x < len ? 'a' + (line + x / 5) % 26 : ' ';
+
+				if (x % 5 == 4)
+					symbol = ' ';
+
+				t_set_cell(x, y, symbol, color);
+			}
+		}
+
+		t_render(rows, cols);
+		switch_grids();
+
+		bytes += t_stats.frame_bytes;
+	}
+
+	double elapsed = bench_now_ns() - started;
+
+	fprintf(stderr, "%4dx%-4d text scroll%s: %9.0f ns/frame, %8.1f B written/frame\n",
+		cols, rows,
+		hardware ? " (scroll region)" : "",
+		elapsed / BENCH_FRAMES,
+		(double)bytes / BENCH_FRAMES);
+}
+
+void bench_diff(int rows, int cols) {
+	t_grids_init(rows, cols);
+	bench_fill_grid(rows, cols);
+
+	t_render(rows, cols);
+	switch_grids();
+
+	uint64_t bytes = 0;
+	double started = bench_now_ns();
+
+	for (int i = 0; i < BENCH_FRAMES; i++) {
+		t_set_cell_symbol(i % cols, rows / 2, 'A' + i % 26);
+		t_damage_rows(0, rows);
+
+		t_render(rows, cols);
+		switch_grids();
+
+		bytes += t_stats.frame_bytes;
+	}
+
+	double elapsed = bench_now_ns() - started;
+
+	fprintf(stderr, "%4dx%-4d full screen diff: %9.0f ns/frame, %6.1f B written/frame, %zu B per cell\n",
+		cols, rows,
+		elapsed / BENCH_FRAMES,
+		(double)bytes / BENCH_FRAMES,
+		sizeof(Cell));
+}
+
+typedef struct {
+	char symbol;
+	terminal_color* color;
+} BenchLegacyCell;
+
+void bench_legacy_copy() {
+	size_t size = sizeof(BenchLegacyCell) * BENCH_LEGACY_GRID_SIZE * BENCH_LEGACY_GRID_SIZE;
+	BenchLegacyCell* from = (BenchLegacyCell*)calloc(BENCH_LEGACY_GRID_SIZE * BENCH_LEGACY_GRID_SIZE, sizeof(BenchLegacyCell));
+	BenchLegacyCell* to = (BenchLegacyCell*)calloc(BENCH_LEGACY_GRID_SIZE * BENCH_LEGACY_GRID_SIZE, sizeof(BenchLegacyCell));
+	int frames = BENCH_FRAMES / 10;
+
+	double started = bench_now_ns();
+
+	for (int i = 0; i < frames; i++) {
+		from[i].symbol = i;
+		memcpy(to, from, size);
+	}
+
+	double elapsed = bench_now_ns() - started;
+
+	fprintf(stderr, "legacy 1024x1024 switch_grids memcpy: %9.0f ns/frame, %zu B copied/frame (%c)\n",
+		elapsed / frames,
+		size,
+		to[frames - 1].symbol ? '+' : '-');
+
+	free(from);
+	free(to);
+}
+
+int main() {
+	t_backend_set(T_BACKEND_NULL);
+	t_set_palette(editor_palette, sizeof(editor_palette) / sizeof(editor_palette[0]));
+
+	bench_legacy_copy();
+	bench_render(24, 80);
+	bench_render(60, 200);
+	bench_scroll(24, 80, false);
+	bench_scroll(24, 80, true);
+	bench_scroll(60, 200, false);
+	bench_scroll(60, 200, true);
+	bench_diff(100, 300);
+}
@@ -0,0 +1,168 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define RENDER_CACHE_SLOTS 4096
+#define RENDER_TAB_WIDTH 4
+#define RENDER_INDEX_SLOTS 256
+#define RENDER_INDEX_STEP 256
+
+typedef struct {
+	uint64_t line_id;
+	uint32_t line_version;
+	int x_offset;
+	int width;
+	TerminalStyle style;
+	SyntaxT* syntax;
+	uint8_t syntax_start;
+	int capacity;
+	Cell* cells;
+} RenderCacheEntryT;
+
+typedef struct {
+	RenderCacheEntryT entries[RENDER_CACHE_SLOTS];
+	uint64_t hits;
+	uint64_t misses;
+} RenderCacheT;
+
+typedef struct {
+	LineItemT* item;
+	int column;
+	int index;
+} RenderCheckpointT;
+
+typedef struct {
+	uint64_t line_id;
+	uint32_t line_version;
+	LineItemT* item;
+	int column;
+	int item_index;
+	int count;
+	int capacity;
+	RenderCheckpointT* checkpoints;
+} RenderColumnIndexT;
+
+RenderCacheT render_cache = {};
+RenderColumnIndexT render_column_index[RENDER_INDEX_SLOTS] = {};
+
+static int render_cache_symbol_width(char symbol) {
+	return symbol == '\t' ? RENDER_TAB_WIDTH : 1;
+}
+
+static RenderCheckpointT render_cache_seek(LineT* line, int column) {
+	RenderCheckpointT start = {.item = line->item_head, .column = 0, .index = 0};
+
+	if (column < RENDER_INDEX_STEP)
+		return start;
+
+	RenderColumnIndexT* index = &render_column_index[line->id & (RENDER_INDEX_SLOTS - 1)];
+
+	if (index->line_id != line->id || index->line_version != line->version) {
+		index->line_id = line->id;
+		index->line_version = line->version;
+		index->item = line->item_head;
+		index->column = 0;
+		index->item_index = 0;
+		index->count = 0;
+	}
+
+	int wanted = column / RENDER_INDEX_STEP;
+
+	while (index->count <= wanted && index->item != NULL) {
+		if (index->column >= index->count * RENDER_INDEX_STEP) {
+			if (index->count == index->capacity) {
+				index->capacity = MAX(16, index->capacity * 2);
+				index->checkpoints = (RenderCheckpointT*)realloc(index->checkpoints, sizeof(RenderCheckpointT) * index->capacity);
+			}
+
+			index->checkpoints[index->count].item = index->item;
+			index->checkpoints[index->count].column = index->column;
+			index->checkpoints[index->count].index = index->item_index;
+			index->count++;
+		}
+
+		index->column += render_cache_symbol_width(index->item->symbol);
+		index->item = index->item->next;
+		index->item_index++;
+	}
+
+	for (int i = MIN(wanted, index->count - 1); i >= 0; i--) {
+		if (index->checkpoints[i].column <= column)
+			return index->checkpoints[i];
+	}
+
+	return start;
+}
+
+static RenderCacheEntryT* render_cache_slot(uint64_t line_id, int x_offset, int width) {
+	uint64_t key = line_id * 0x9e3779b97f4a7c15ULL ^ (uint64_t)x_offset * 0xc2b2ae3d27d4eb4fULL ^ (uint64_t)width;
+
+	return &render_cache.entries[(key ^ key >> 29) & (RENDER_CACHE_SLOTS - 1)];
+}
+
+static void render_cache_put(Cell* cells, int column, int x_offset, int width, char symbol, TerminalStyle style) {
+	if (column < x_offset || column >= x_offset + width)
+		return;
+
+	cells[column - x_offset].symbol = symbol;
+	cells[column - x_offset].style = style;
+}
+
+static void render_cache_render_line(LineT* line, int x_offset, int width, TerminalStyle base_style, SyntaxT* syntax, Cell* cells) {
+	RenderCheckpointT start = render_cache_seek(line, x_offset);
+	uint8_t* classes = syntax != NULL ? syntax_line_classes(syntax, line) : NULL;
+	int column = start.column;
+	int index = start.index;
+
+	for (LineItemT* item = start.item; item != NULL && column < x_offset + width; item = item->next, index++) {
+		TerminalStyle style = classes != NULL ? base_style + classes[index] : base_style;
+
+		if (item->symbol == '\t') {
+			for (int i = 0; i < RENDER_TAB_WIDTH; i++)
+				render_cache_put(cells, column + i, x_offset, width, i == 0 ? '>' : ' ', style);
+
+			column += RENDER_TAB_WIDTH;
+		} else {
+			render_cache_put(cells, column, x_offset, width, item->symbol == '\n' ? '<' : item->symbol, style);
+			column++;
+		}
+	}
+
+	for (; column < x_offset + width; column++)
+		render_cache_put(cells, column, x_offset, width, ' ', base_style);
+}
+
+Cell* render_cache_line(LineT* line, int x_offset, int width, TerminalStyle style, SyntaxT* syntax) {
+	RenderCacheEntryT* entry = render_cache_slot(line->id, x_offset, width);
+
+	if (entry->line_id == line->id &&
+			entry->line_version == line->version &&
+			entry->x_offset == x_offset &&
+			entry->width == width &&
+			entry->style == style &&
+			entry->syntax == syntax &&
+			(syntax == NULL || entry->syntax_start == line->syntax_start)) {
+		render_cache.hits++;
+
+		return entry->cells;
+	}
+
+	render_cache.misses++;
+
+	if (entry->capacity < width) {
+		entry->cells = (Cell*)realloc(entry->cells, sizeof(Cell) * width);
+		entry->capacity = width;
+	}
+
+	render_cache_render_line(line, x_offset, width, style, syntax, entry->cells);
+
+	entry->line_id = line->id;
+	entry->line_version = line->version;
+	entry->x_offset = x_offset;
+	entry->width = width;
+	entry->style = style;
+	entry->syntax = syntax;
+	entry->syntax_start = line->syntax_start;
+
+	return entry->cells;
+}
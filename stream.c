@@ -0,0 +1,157 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define STREAM_CHUNK_SIZE (64 * 1024)
+#define STREAM_MAX_QUEUED_CHUNKS 64
+
+typedef struct StreamChunk {
+	size_t size;
+	struct StreamChunk* next;
+	char data[STREAM_CHUNK_SIZE];
+} StreamChunkT;
+
+typedef struct {
+	int fd;
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t not_full;
+	StreamChunkT* head;
+	StreamChunkT* tail;
+	int queued;
+	bool eof;
+	int notify_pipe[2];
+} StreamT;
+
+static void* stream_thread_main(void* arg) {
+	StreamT* stream = (StreamT*)arg;
+
+	while (true) {
+		StreamChunkT* chunk = (StreamChunkT*)malloc(sizeof(StreamChunkT));
+		chunk->size = 0;
+		chunk->next = NULL;
+
+		ssize_t n;
+
+		do {
+			n = read(stream->fd, chunk->data, STREAM_CHUNK_SIZE);
+		} while (n < 0 && errno == EINTR);
+
+		if (n > 0)
+			chunk->size = n;
+
+		pthread_mutex_lock(&stream->mutex);
+
+		while (stream->queued >= STREAM_MAX_QUEUED_CHUNKS)
+			pthread_cond_wait(&stream->not_full, &stream->mutex);
+
+		bool eof = chunk->size == 0;
+
+		if (eof) {
+			free(chunk);
+			stream->eof = true;
+		} else {
+			if (stream->tail == NULL)
+				stream->head = chunk;
+			else
+				stream->tail->next = chunk;
+
+			stream->tail = chunk;
+			stream->queued++;
+		}
+
+		pthread_mutex_unlock(&stream->mutex);
+
+		char byte = 1;
+		write(stream->notify_pipe[1], &byte, 1);
+
+		if (eof)
+			break;
+	}
+
+	return NULL;
+}
+
+StreamT* stream_start(int fd) {
+	StreamT* stream = (StreamT*)malloc(sizeof(StreamT));
+	stream->fd = fd;
+	stream->head = NULL;
+	stream->tail = NULL;
+	stream->queued = 0;
+	stream->eof = false;
+
+	pthread_mutex_init(&stream->mutex, NULL);
+	pthread_cond_init(&stream->not_full, NULL);
+
+	pipe(stream->notify_pipe);
+	fcntl(stream->notify_pipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(stream->notify_pipe[1], F_SETFL, O_NONBLOCK);
+
+	pthread_create(&stream->thread, NULL, stream_thread_main, stream);
+
+	return stream;
+}
+
+int stream_notify_fd(StreamT* stream) {
+	return stream->notify_pipe[0];
+}
+
+StreamChunkT* stream_take(StreamT* stream) {
+	char bytes[64];
+
+	while (read(stream->notify_pipe[0], bytes, sizeof(bytes)) > 0);
+
+	pthread_mutex_lock(&stream->mutex);
+
+	StreamChunkT* chunk = stream->head;
+
+	if (chunk != NULL) {
+		stream->head = chunk->next;
+
+		if (stream->head == NULL)
+			stream->tail = NULL;
+
+		stream->queued--;
+		pthread_cond_signal(&stream->not_full);
+	}
+
+	pthread_mutex_unlock(&stream->mutex);
+
+	return chunk;
+}
+
+bool stream_has_chunks(StreamT* stream) {
+	pthread_mutex_lock(&stream->mutex);
+
+	bool has_chunks = stream->head != NULL;
+
+	pthread_mutex_unlock(&stream->mutex);
+
+	return has_chunks;
+}
+
+bool stream_finished(StreamT* stream) {
+	pthread_mutex_lock(&stream->mutex);
+
+	bool finished = stream->eof && stream->head == NULL;
+
+	pthread_mutex_unlock(&stream->mutex);
+
+	return finished;
+}
+
+void stream_free(StreamT* stream) {
+	pthread_join(stream->thread, NULL);
+
+	close(stream->notify_pipe[0]);
+	close(stream->notify_pipe[1]);
+
+	pthread_mutex_destroy(&stream->mutex);
+	pthread_cond_destroy(&stream->not_full);
+
+	free(stream);
+}
@@ -0,0 +1,366 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SYNTAX_CACHE_SLOTS 4096
+#define SYNTAX_MAX_WORD 64
+#define SYNTAX_CONVERGE_LINES 2048
+
+typedef enum {
+	SYNTAX_NONE,
+	SYNTAX_KEYWORD,
+	SYNTAX_TYPE,
+	SYNTAX_STRING,
+	SYNTAX_NUMBER,
+	SYNTAX_COMMENT,
+	SYNTAX_PREPROC,
+} SyntaxClass;
+
+typedef enum {
+	SYNTAX_STATE_NORMAL,
+	SYNTAX_STATE_BLOCK_COMMENT,
+} SyntaxState;
+
+typedef struct {
+	const char* name;
+	const char* extensions[8];
+	const char* keywords[48];
+	const char* types[32];
+	const char* line_comments[3];
+	const char* block_comment_start;
+	const char* block_comment_end;
+	const char* quotes;
+	bool preprocessor;
+} SyntaxT;
+
+typedef struct {
+	uint64_t line_id;
+	uint32_t line_version;
+	uint8_t start;
+	SyntaxT* syntax;
+	int capacity;
+	uint8_t* classes;
+} SyntaxCacheEntryT;
+
+SyntaxT syntaxes[] = {
+	{
+		.name = "c",
+		.extensions = {".c", ".h", ".cc", ".cpp", ".hpp", NULL},
+		.keywords = {
+			"break", "case", "continue", "default", "do", "else", "for", "goto", "if",
+			"return", "sizeof", "switch", "while", "typedef", "struct", "union", "enum",
+			"static", "extern", "const", "volatile", "inline", "register", "restrict",
+			"true", "false", "NULL", NULL,
+		},
+		.types = {
+			"void", "char", "short", "int", "long", "float", "double", "signed", "unsigned",
+			"bool", "size_t", "ssize_t", "off_t", "int8_t", "int16_t", "int32_t", "int64_t",
+			"uint8_t", "uint16_t", "uint32_t", "uint64_t", "FILE", NULL,
+		},
+		.line_comments = {"//", NULL},
+		.block_comment_start = "/*",
+		.block_comment_end = "*/",
+		.quotes = "\"'",
+		.preprocessor = true,
+	},
+	{
+		.name = "json",
+		.extensions = {".json", NULL},
+		.keywords = {"true", "false", "null", NULL},
+		.types = {NULL},
+		.line_comments = {NULL},
+		.quotes = "\"",
+	},
+	{
+		.name = "yaml",
+		.extensions = {".yml", ".yaml", NULL},
+		.keywords = {"true", "false", "null", "yes", "no", "on", "off", NULL},
+		.types = {NULL},
+		.line_comments = {"#", NULL},
+		.quotes = "\"'",
+	},
+	{
+		.name = "ini",
+		.extensions = {".ini", ".conf", ".cfg", ".toml", NULL},
+		.keywords = {"true", "false", "yes", "no", "on", "off", NULL},
+		.types = {NULL},
+		.line_comments = {"#", ";", NULL},
+		.quotes = "\"'",
+	},
+	{
+		.name = "sh",
+		.extensions = {".sh", ".bash", "Makefile", "makefile", ".mk", NULL},
+		.keywords = {
+			"if", "then", "else", "elif", "fi", "for", "while", "until", "do", "done",
+			"case", "esac", "in", "function", "return", "export", "local", NULL,
+		},
+		.types = {NULL},
+		.line_comments = {"#", NULL},
+		.quotes = "\"'",
+	},
+};
+
+SyntaxCacheEntryT syntax_cache[SYNTAX_CACHE_SLOTS] = {};
+
+static bool syntax_name_matches(const char* name, const char* pattern) {
+	int name_len = strlen(name);
+	int pattern_len = strlen(pattern);
+
+	if (pattern[0] != '.')
+		return !strcmp(name, pattern);
+
+	return name_len > pattern_len && !strcmp(name + name_len - pattern_len, pattern);
+}
+
+SyntaxT* syntax_for_filename(const char* filename) {
+	char name[4096];
+	const char* base = strrchr(filename, '/');
+
+	snprintf(name, sizeof(name), "%s", base != NULL ? base + 1 : filename);
+
+	int len = strlen(name);
+
+	if (len > 3 && !strcmp(name + len - 3, ".gz"))
+		name[len - 3] = 0;
+
+	for (size_t i = 0; i < sizeof(syntaxes) / sizeof(syntaxes[0]); i++) {
+		for (int j = 0; syntaxes[i].extensions[j] != NULL; j++) {
+			if (syntax_name_matches(name, syntaxes[i].extensions[j]))
+				return &syntaxes[i];
+		}
+	}
+
+	return NULL;
+}
+
+static bool syntax_is_word_symbol(char symbol) {
+	return (symbol >= 'a' && symbol <= 'z') || (symbol >= 'A' && symbol <= 'Z') ||
+		(symbol >= '0' && symbol <= '9') || symbol == '_';
+}
+
+static bool syntax_is_digit(char symbol) {
+	return symbol >= '0' && symbol <= '9';
+}
+
+static bool syntax_in_list(const char* const* list, const char* word) {
+	for (int i = 0; list[i] != NULL; i++) {
+		if (!strcmp(list[i], word))
+			return true;
+	}
+
+	return false;
+}
+
+static int syntax_match(LineItemT* item, const char* text) {
+	if (text == NULL)
+		return 0;
+
+	int len = 0;
+
+	for (; text[len] != 0; len++, item = item->next) {
+		if (item == NULL || item->symbol != text[len])
+			return 0;
+	}
+
+	return len;
+}
+
+static void syntax_mark(uint8_t* classes, int* index, LineItemT** item, int count, SyntaxClass class) {
+	for (int i = 0; i < count && *item != NULL; i++) {
+		if (classes != NULL)
+			classes[*index] = class;
+
+		*item = (*item)->next;
+		(*index)++;
+	}
+}
+
+static int syntax_run(LineItemT* item, bool (*accept)(char)) {
+	int count = 0;
+
+	for (; item != NULL && accept(item->symbol); item = item->next)
+		count++;
+
+	return count;
+}
+
+static void syntax_mark_rest(uint8_t* classes, int* index, LineItemT** item, SyntaxClass class) {
+	while (*item != NULL && (*item)->symbol != '\n')
+		syntax_mark(classes, index, item, 1, class);
+}
+
+static bool syntax_starts_line_comment(SyntaxT* syntax, LineItemT* item) {
+	for (int i = 0; syntax->line_comments[i] != NULL; i++) {
+		if (syntax_match(item, syntax->line_comments[i]))
+			return true;
+	}
+
+	return false;
+}
+
+uint8_t syntax_lex_line(SyntaxT* syntax, LineT* line, uint8_t state, uint8_t* classes) {
+	LineItemT* item = line->item_head;
+	int index = 0;
+	bool line_start = true;
+	char prev = 0;
+
+	while (item != NULL) {
+		if (state == SYNTAX_STATE_BLOCK_COMMENT) {
+			int end = syntax_match(item, syntax->block_comment_end);
+
+			if (end) {
+				syntax_mark(classes, &index, &item, end, SYNTAX_COMMENT);
+				state = SYNTAX_STATE_NORMAL;
+			} else {
+				syntax_mark(classes, &index, &item, 1, SYNTAX_COMMENT);
+			}
+
+			continue;
+		}
+
+		char symbol = item->symbol;
+		int start = syntax_match(item, syntax->block_comment_start);
+
+		if (start) {
+			syntax_mark(classes, &index, &item, start, SYNTAX_COMMENT);
+			state = SYNTAX_STATE_BLOCK_COMMENT;
+		} else if (syntax_starts_line_comment(syntax, item)) {
+			syntax_mark_rest(classes, &index, &item, SYNTAX_COMMENT);
+		} else if (syntax->preprocessor && line_start && symbol == '#') {
+			syntax_mark_rest(classes, &index, &item, SYNTAX_PREPROC);
+		} else if (syntax->quotes != NULL && symbol != 0 && strchr(syntax->quotes, symbol) != NULL) {
+			syntax_mark(classes, &index, &item, 1, SYNTAX_STRING);
+
+			while (item != NULL && item->symbol != '\n') {
+				char string_symbol = item->symbol;
+
+				if (string_symbol == '\\' && item->next != NULL && item->next->symbol != '\n') {
+					syntax_mark(classes, &index, &item, 2, SYNTAX_STRING);
+
+					continue;
+				}
+
+				syntax_mark(classes, &index, &item, 1, SYNTAX_STRING);
+
+				if (string_symbol == symbol)
+					break;
+			}
+		} else if (syntax_is_digit(symbol) && !syntax_is_word_symbol(prev)) {
+			syntax_mark(classes, &index, &item, syntax_run(item, syntax_is_word_symbol), SYNTAX_NUMBER);
+		} else if (syntax_is_word_symbol(symbol)) {
+			char word[SYNTAX_MAX_WORD];
+			int len = 0;
+
+			for (LineItemT* w = item; w != NULL && syntax_is_word_symbol(w->symbol); w = w->next) {
+				if (len < SYNTAX_MAX_WORD - 1)
+					word[len] = w->symbol;
+
+				len++;
+			}
+
+			word[MIN(len, SYNTAX_MAX_WORD - 1)] = 0;
+
+			SyntaxClass class = SYNTAX_NONE;
+
+			if (len < SYNTAX_MAX_WORD && syntax_in_list(syntax->keywords, word))
+				class = SYNTAX_KEYWORD;
+			else if (len < SYNTAX_MAX_WORD && syntax_in_list(syntax->types, word))
+				class = SYNTAX_TYPE;
+
+			syntax_mark(classes, &index, &item, len, class);
+		} else {
+			syntax_mark(classes, &index, &item, 1, SYNTAX_NONE);
+		}
+
+		if (symbol != ' ' && symbol != '\t')
+			line_start = false;
+
+		prev = symbol;
+	}
+
+	return state;
+}
+
+bool syntax_line_trusted(LineT* line, uint32_t epoch) {
+	return line->syntax_valid && line->syntax_epoch == epoch;
+}
+
+uint8_t syntax_line_sync(SyntaxT* syntax, LineT* line, uint8_t start, uint32_t epoch) {
+	if (syntax == NULL)
+		return SYNTAX_STATE_NORMAL;
+
+	if (!line->syntax_valid || line->syntax_start != start) {
+		line->syntax_start = start;
+		line->syntax_end = syntax_lex_line(syntax, line, start, NULL);
+		line->syntax_valid = true;
+	}
+
+	line->syntax_epoch = epoch;
+
+	return line->syntax_end;
+}
+
+uint8_t syntax_state_before(SyntaxT* syntax, LineT* line, uint32_t epoch) {
+	if (syntax == NULL)
+		return SYNTAX_STATE_NORMAL;
+
+	LineT* from = line;
+
+	while (from->prev != NULL && !syntax_line_trusted(from->prev, epoch))
+		from = from->prev;
+
+	uint8_t state = from->prev != NULL ? from->prev->syntax_end : SYNTAX_STATE_NORMAL;
+
+	for (; from != line; from = from->next)
+		state = syntax_line_sync(syntax, from, state, epoch);
+
+	return state;
+}
+
+void syntax_converge(SyntaxT* syntax, LineT* line, uint8_t state, uint32_t* epoch) {
+	if (syntax == NULL)
+		return;
+
+	for (int i = 0; line != NULL && syntax_line_trusted(line, *epoch) && line->syntax_start != state; i++) {
+		if (i == SYNTAX_CONVERGE_LINES) {
+			(*epoch)++;
+
+			return;
+		}
+
+		state = syntax_line_sync(syntax, line, state, *epoch);
+		line = line->next;
+	}
+}
+
+uint8_t* syntax_line_classes(SyntaxT* syntax, LineT* line) {
+	uint64_t key = line->id * 0x9e3779b97f4a7c15ULL;
+	SyntaxCacheEntryT* entry = &syntax_cache[(key ^ key >> 29) & (SYNTAX_CACHE_SLOTS - 1)];
+
+	if (entry->line_id == line->id &&
+			entry->line_version == line->version &&
+			entry->start == line->syntax_start &&
+			entry->syntax == syntax)
+		return entry->classes;
+
+	int count = 0;
+
+	for (LineItemT* item = line->item_head; item != NULL; item = item->next)
+		count++;
+
+	if (entry->capacity < count) {
+		entry->capacity = MAX(count, entry->capacity * 2);
+		entry->classes = (uint8_t*)realloc(entry->classes, entry->capacity);
+	}
+
+	syntax_lex_line(syntax, line, line->syntax_start, entry->classes);
+
+	entry->line_id = line->id;
+	entry->line_version = line->version;
+	entry->start = line->syntax_start;
+	entry->syntax = syntax;
+
+	return entry->classes;
+}
@@ -1,69 +1,1013 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <termios.h>
+#include <time.h>
 #include <unistd.h>
-#define MAX_GRID_SIZE 1024
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "calc.h"
+
+#define T_FRAME_INITIAL_CAPACITY (256 * 1024)
+#define T_MAX_REPRINT_GAP 8
+#define T_STYLE_UNKNOWN 0xff
+#define T_SNAPSHOTS 3
 
 typedef char terminal_color[64];
+typedef uint8_t TerminalStyle;
 
 typedef struct {
 	char symbol;
-	terminal_color* color;
+	TerminalStyle style;
 } Cell;
 
-typedef Cell Grid[MAX_GRID_SIZE][MAX_GRID_SIZE];
+typedef Cell** Grid;
+
+typedef struct {
+	int from;
+	int to;
+} TerminalDamage;
+
+typedef struct {
+	Cell* cells;
+	int x;
+	TerminalDamage* damage;
+} TerminalRow;
+
+typedef enum {
+	T_BACKEND_TERMINAL,
+	T_BACKEND_MEMORY,
+	T_BACKEND_NULL,
+} TerminalBackendType;
+
+typedef struct {
+	TerminalBackendType type;
+	char* data;
+	size_t size;
+	size_t capacity;
+} TerminalBackend;
+
+typedef struct {
+	char* data;
+	size_t size;
+	size_t capacity;
+} TerminalFrame;
+
+typedef struct {
+	int x;
+	int y;
+	TerminalStyle style;
+} TerminalState;
+
+typedef struct {
+	uint64_t frames;
+	uint64_t bytes;
+	uint64_t syscalls;
+	size_t frame_bytes;
+	int frame_syscalls;
+	size_t grid_bytes_copied;
+	int rows_damaged;
+	int cells_visited;
+	uint64_t scrolls;
+	uint64_t frames_published;
+	uint64_t frames_dropped;
+	uint64_t queue_ns_last;
+	uint64_t queue_ns_max;
+} TerminalStats;
+
+typedef enum {
+	T_OP_CLEAR_SCREEN,
+	T_OP_MOVE_CURSOR,
+	T_OP_SET_COLOR,
+	T_OP_SCROLL_ROWS,
+	T_OP_INVALIDATE,
+	T_OP_RESIZE,
+} TerminalOpType;
+
+typedef struct {
+	TerminalOpType type;
+	int x;
+	int y;
+	int top;
+	int bottom;
+	int count;
+	int rows;
+	int cols;
+	const char* color;
+} TerminalOp;
+
+typedef struct {
+	TerminalOp* items;
+	int count;
+	int capacity;
+} TerminalOpList;
+
+typedef struct {
+	Grid grid;
+	int rows;
+	int cols;
+	TerminalDamage* damage;
+	TerminalDamage* stale;
+	TerminalOpList ops;
+	int64_t published_ns;
+} TerminalSnapshot;
+
+typedef struct {
+	bool running;
+	bool stopping;
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t frame_cond;
+	pthread_cond_t idle_cond;
+	TerminalSnapshot snapshots[T_SNAPSHOTS];
+	int front;
+	int pending;
+	TerminalOpList ops;
+	uint64_t published;
+	uint64_t dropped;
+	TerminalStats stats;
+} TerminalRenderThread;
 
 static struct termios old_termios, new_termios;
 
-Grid rendered_grid = {};
-Grid current_grid = {};
+Grid rendered_grid = NULL;
+Grid current_grid = NULL;
+
+int t_grid_rows = 0;
+int t_grid_cols = 0;
+uint64_t t_grid_generation = 0;
+static TerminalDamage* t_damage = NULL;
+
+static Grid t_frame_grid = NULL;
+static int t_rendered_rows = 0;
+static int t_rendered_cols = 0;
+
+int t_input_fd = STDIN_FILENO;
+
+TerminalBackend t_backend = {.type = T_BACKEND_TERMINAL};
+TerminalFrame t_frame = {};
+TerminalStats t_stats = {};
+TerminalState t_state = {.x = -1, .y = -1, .style = T_STYLE_UNKNOWN};
+TerminalRenderThread t_thread = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+	.frame_cond = PTHREAD_COND_INITIALIZER,
+	.idle_cond = PTHREAD_COND_INITIALIZER,
+	.front = -1,
+	.pending = -1,
+};
+
+static void t_op(TerminalOp op);
+void t_flush();
+
+static terminal_color* t_palette = NULL;
+static int t_palette_size = 0;
+static TerminalStyle t_palette_alias[T_STYLE_UNKNOWN + 1];
+
+void t_set_palette(terminal_color* palette, int size) {
+	t_palette = palette;
+	t_palette_size = MIN(size, T_STYLE_UNKNOWN);
+
+	for (int i = 0; i <= T_STYLE_UNKNOWN; i++)
+		t_palette_alias[i] = T_STYLE_UNKNOWN;
+
+	for (int i = 0; i < t_palette_size; i++) {
+		t_palette_alias[i] = i;
+
+		for (int j = 0; j < i; j++) {
+			if (!strcmp(palette[i], palette[j])) {
+				t_palette_alias[i] = j;
+				break;
+			}
+		}
+	}
+}
+
+static Grid t_grid_new(int rows, int cols) {
+	Grid grid = (Grid)malloc(sizeof(Cell*) * rows);
+	Cell* cells = (Cell*)calloc((size_t)rows * cols, sizeof(Cell));
+
+	for (int y = 0; y < rows; y++)
+		grid[y] = cells + (size_t)y * cols;
+
+	return grid;
+}
+
+static void t_grid_free(Grid grid) {
+	if (grid == NULL)
+		return;
+
+	free(grid[0]);
+	free(grid);
+}
+
+static void t_damage_clear(int y) {
+	t_damage[y].from = t_grid_cols;
+	t_damage[y].to = 0;
+}
+
+static void t_damage_mark(TerminalDamage* damage, int x) {
+	if (x < damage->from)
+		damage->from = x;
+
+	if (x + 1 > damage->to)
+		damage->to = x + 1;
+}
+
+static void t_damage_merge(TerminalDamage* damage, TerminalDamage other) {
+	if (other.from >= other.to)
+		return;
+
+	damage->from = MIN(damage->from, other.from);
+	damage->to = MAX(damage->to, other.to);
+}
+
+void t_grids_init(int rows, int cols) {
+	t_grid_free(current_grid);
+	free(t_damage);
+
+	current_grid = t_grid_new(rows, cols);
+	t_damage = (TerminalDamage*)malloc(sizeof(TerminalDamage) * rows);
+
+	t_grid_rows = rows;
+	t_grid_cols = cols;
+	t_grid_generation++;
+
+	for (int y = 0; y < rows; y++)
+		t_damage_clear(y);
+
+	t_op((TerminalOp){.type = T_OP_RESIZE, .rows = rows, .cols = cols});
+}
+
+static void t_apply_resize(int rows, int cols) {
+	t_grid_free(rendered_grid);
+
+	rendered_grid = t_grid_new(rows, cols);
+	t_rendered_rows = rows;
+	t_rendered_cols = cols;
+}
+
+void t_damage_rows(int from, int to) {
+	for (int y = from; y < to; y++) {
+		t_damage[y].from = 0;
+		t_damage[y].to = t_grid_cols;
+	}
+}
+
+TerminalRow t_row(int x, int y) {
+	return (TerminalRow){.cells = current_grid[y] + x, .x = x, .damage = &t_damage[y]};
+}
+
+void t_row_set(TerminalRow* row, int x, char symbol, TerminalStyle style) {
+	Cell* cell = &row->cells[x];
+
+	if (cell->symbol == symbol && cell->style == style)
+		return;
+
+	cell->symbol = symbol;
+	cell->style = style;
+
+	t_damage_mark(row->damage, row->x + x);
+}
+
+void t_row_set_symbol(TerminalRow* row, int x, char symbol) {
+	t_row_set(row, x, symbol, row->cells[x].style);
+}
+
+void t_row_set_style(TerminalRow* row, int x, TerminalStyle style) {
+	t_row_set(row, x, row->cells[x].symbol, style);
+}
+
+void t_set_cell(int x, int y, char symbol, TerminalStyle style) {
+	TerminalRow row = t_row(x, y);
+
+	t_row_set(&row, 0, symbol, style);
+}
+
+void t_set_cell_symbol(int x, int y, char symbol) {
+	t_set_cell(x, y, symbol, current_grid[y][x].style);
+}
+
+void t_set_cell_style(int x, int y, TerminalStyle style) {
+	t_set_cell(x, y, current_grid[y][x].symbol, style);
+}
+
+void t_invalidate() {
+	t_op((TerminalOp){.type = T_OP_INVALIDATE});
+	t_damage_rows(0, t_grid_rows);
+}
+
+static void t_apply_invalidate() {
+	t_state.x = -1;
+	t_state.y = -1;
+	t_state.style = T_STYLE_UNKNOWN;
+
+	for (int y = 0; y < t_rendered_rows; y++)
+		memset(rendered_grid[y], T_STYLE_UNKNOWN, sizeof(Cell) * t_rendered_cols);
+}
+
+void t_switch_grids() {
+	if (t_thread.running)
+		return;
+
+	t_stats.grid_bytes_copied = 0;
+
+	for (int y = 0; y < t_grid_rows; y++) {
+		TerminalDamage damage = t_damage[y];
+
+		if (damage.from >= damage.to)
+			continue;
+
+		memcpy(rendered_grid[y] + damage.from, current_grid[y] + damage.from, sizeof(Cell) * (damage.to - damage.from));
+
+		t_damage_clear(y);
+		t_stats.grid_bytes_copied += sizeof(Cell) * (damage.to - damage.from);
+	}
+}
+
+void t_backend_set(TerminalBackendType type) {
+	t_backend.type = type;
+	t_backend.size = 0;
+}
+
+static ssize_t t_backend_write(char* data, size_t size) {
+	switch (t_backend.type) {
+		case T_BACKEND_TERMINAL:
+			return write(STDOUT_FILENO, data, size);
+
+		case T_BACKEND_MEMORY:
+			if (t_backend.size + size > t_backend.capacity) {
+				size_t capacity = t_backend.capacity > 0 ? t_backend.capacity : T_FRAME_INITIAL_CAPACITY;
+
+				while (t_backend.size + size > capacity)
+					capacity *= 2;
+
+				t_backend.data = (char*)realloc(t_backend.data, capacity);
+				t_backend.capacity = capacity;
+			}
+
+			memcpy(t_backend.data + t_backend.size, data, size);
+			t_backend.size += size;
+
+			return size;
+
+		case T_BACKEND_NULL:
+			return size;
+	}
+
+	return size;
+}
+
+void t_grid_dump(FILE* file) {
+	for (int y = 0; y < t_rendered_rows; y++) {
+		int len = t_rendered_cols;
+
+		while (len > 0 && (rendered_grid[y][len - 1].symbol == ' ' || rendered_grid[y][len - 1].symbol == 0))
+			len--;
+
+		for (int x = 0; x < len; x++) {
+			unsigned char symbol = rendered_grid[y][x].symbol;
+
+			fputc(symbol < 32 || symbol == 127 ? ' ' : symbol, file);
+		}
+
+		fputc('\n', file);
+	}
+}
 
 void t_configure_terminal() {
-	tcgetattr(STDIN_FILENO, &old_termios);
+	if (t_backend.type != T_BACKEND_TERMINAL)
+		return;
+
+	tcgetattr(t_input_fd, &old_termios);
 	new_termios = old_termios;
 
 	new_termios.c_lflag &= ~(ICANON | ECHO);
 	new_termios.c_cc[VMIN] = 1;
 	new_termios.c_cc[VTIME] = 0;
 
-	tcsetattr(STDIN_FILENO, TCSANOW, &new_termios);
+	tcsetattr(t_input_fd, TCSANOW, &new_termios);
 
 	printf("\e[?25l");
 }
 
 void t_restore_terminal() {
+	if (t_backend.type != T_BACKEND_TERMINAL)
+		return;
+
+	t_flush();
+
 	printf("\e[?25h");
 	printf("\e[m");
 	fflush(stdout);
 
-	tcsetattr(STDIN_FILENO, TCSANOW, &old_termios);
+	tcsetattr(t_input_fd, TCSANOW, &old_termios);
+}
+
+void t_frame_reserve(size_t size) {
+	if (t_frame.size + size <= t_frame.capacity)
+		return;
+
+	size_t capacity = t_frame.capacity > 0 ? t_frame.capacity : T_FRAME_INITIAL_CAPACITY;
+
+	while (t_frame.size + size > capacity)
+		capacity *= 2;
+
+	t_frame.data = (char*)realloc(t_frame.data, capacity);
+	t_frame.capacity = capacity;
+}
+
+void t_frame_append(const char* data, size_t size) {
+	t_frame_reserve(size);
+
+	memcpy(t_frame.data + t_frame.size, data, size);
+	t_frame.size += size;
+}
+
+void t_frame_append_int(int value) {
+	char digits[16];
+	int len = 0;
+
+	do {
+		digits[len++] = '0' + value % 10;
+		value /= 10;
+	} while (value > 0);
+
+	t_frame_reserve(len);
+
+	while (len > 0)
+		t_frame.data[t_frame.size++] = digits[--len];
+}
+
+static int t_digits_count(int value) {
+	int count = 1;
+
+	while (value >= 10) {
+		value /= 10;
+		count++;
+	}
+
+	return count;
+}
+
+static int t_csi_len(int count) {
+	return count == 1 ? 3 : 3 + t_digits_count(count);
+}
+
+static void t_frame_csi(int count, char command) {
+	t_frame_append("\e[", 2);
+
+	if (count != 1)
+		t_frame_append_int(count);
+
+	t_frame_append(&command, 1);
+}
+
+static bool t_gap_reprintable(int from, int to, int y) {
+	if (to - from > T_MAX_REPRINT_GAP || t_state.style == T_STYLE_UNKNOWN)
+		return false;
+
+	for (int x = from; x < to; x++) {
+		unsigned char symbol = t_frame_grid[y][x].symbol;
+
+		if (t_palette_alias[t_frame_grid[y][x].style] != t_state.style || symbol < 32 || symbol >= 127)
+			return false;
+	}
+
+	return true;
+}
+
+static void t_frame_move_cursor_absolute(int x, int y) {
+	t_frame_append("\e[", 2);
+	t_frame_append_int(y + 1);
+	t_frame_append(";", 1);
+	t_frame_append_int(x + 1);
+	t_frame_append("H", 1);
+}
+
+void t_frame_move_cursor(int x, int y) {
+	if (t_state.x == x && t_state.y == y)
+		return;
+
+	int absolute = 4 + t_digits_count(y + 1) + t_digits_count(x + 1);
+
+	if (t_state.x < 0) {
+		t_frame_move_cursor_absolute(x, y);
+	} else {
+		int dx = x - t_state.x;
+		int dy = y - t_state.y;
+		int vertical = dy == 0 ? 0 : t_csi_len(abs(dy));
+		int relative = vertical + (dx == 0 ? 0 : t_csi_len(abs(dx)));
+		int carriage = vertical + 1 + (x == 0 ? 0 : t_csi_len(x));
+
+		if (dy == 0 && dx > 0 && dx <= MIN(relative, absolute) && t_gap_reprintable(t_state.x, x, y)) {
+			for (int i = t_state.x; i < x; i++)
+				t_frame_append(&t_frame_grid[y][i].symbol, 1);
+		} else if (absolute < relative && absolute < carriage) {
+			t_frame_move_cursor_absolute(x, y);
+		} else {
+			if (dy != 0)
+				t_frame_csi(abs(dy), dy > 0 ? 'B' : 'A');
+
+			if (relative <= carriage) {
+				if (dx != 0)
+					t_frame_csi(abs(dx), dx > 0 ? 'C' : 'D');
+			} else {
+				t_frame_append("\r", 1);
+
+				if (x != 0)
+					t_frame_csi(x, 'C');
+			}
+		}
+	}
+
+	t_state.x = x;
+	t_state.y = y;
+}
+
+void t_frame_put_cell(int x, int y, int cols, Cell cell) {
+	t_frame_move_cursor(x, y);
+
+	TerminalStyle style = t_palette_alias[cell.style];
+
+	if (t_state.style != style && style != T_STYLE_UNKNOWN) {
+		t_frame_append(t_palette[style], strlen(t_palette[style]));
+		t_state.style = style;
+	}
+
+	unsigned char symbol = cell.symbol;
+
+	if (symbol < 32 || symbol == 127)
+		symbol = ' ';
+
+	t_frame_append((char*)&symbol, 1);
+
+	t_state.x = x + 1 < cols && symbol < 128 ? x + 1 : -1;
+}
+
+static void t_apply_clear_screen() {
+	t_frame_append("\e[1;1H\e[2J", 10);
+
+	t_state.x = 0;
+	t_state.y = 0;
+}
+
+static void t_apply_move_cursor(int x, int y) {
+	t_frame_move_cursor_absolute(x, y);
+
+	t_state.x = x;
+	t_state.y = y;
+}
+
+static void t_apply_set_color(const char* color) {
+	t_frame_append(color, strlen(color));
+
+	t_state.style = T_STYLE_UNKNOWN;
+}
+
+void t_frame_flush() {
+	size_t written = 0;
+
+	t_stats.frame_bytes = t_frame.size;
+	t_stats.frame_syscalls = 0;
+
+	if (t_backend.type == T_BACKEND_TERMINAL)
+		fflush(stdout);
+
+	while (written < t_frame.size) {
+		ssize_t n = t_backend_write(t_frame.data + written, t_frame.size - written);
+
+		t_stats.frame_syscalls++;
+
+		if (n < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+
+			break;
+		}
+
+		written += n;
+	}
+
+	t_stats.frames++;
+	t_stats.bytes += t_frame.size;
+	t_stats.syscalls += t_stats.frame_syscalls;
+
+	t_frame.size = 0;
+}
+
+void t_scroll_rows(int top, int bottom, int count) {
+	int height = bottom - top;
+
+	if (count == 0 || abs(count) >= height)
+		return;
+
+	t_op((TerminalOp){.type = T_OP_SCROLL_ROWS, .top = top, .bottom = bottom, .count = count});
+	t_damage_rows(top, bottom);
+}
+
+static void t_apply_scroll_rows(int top, int bottom, int count) {
+	t_frame_append("\e[0m\e[", 6);
+	t_frame_append_int(top + 1);
+	t_frame_append(";", 1);
+	t_frame_append_int(bottom);
+	t_frame_append("r", 1);
+	t_frame_csi(abs(count), count > 0 ? 'S' : 'T');
+	t_frame_append("\e[r", 3);
+
+	t_state.x = -1;
+	t_state.y = -1;
+	t_state.style = T_STYLE_UNKNOWN;
+
+	if (count > 0) {
+		for (int y = top; y < bottom - count; y++)
+			memcpy(rendered_grid[y], rendered_grid[y + count], sizeof(Cell) * t_rendered_cols);
+	} else {
+		for (int y = bottom - 1; y >= top - count; y--)
+			memcpy(rendered_grid[y], rendered_grid[y + count], sizeof(Cell) * t_rendered_cols);
+	}
+
+	int exposed_from = count > 0 ? bottom - count : top;
+	int exposed_to = count > 0 ? bottom : top - count;
+
+	for (int y = exposed_from; y < exposed_to; y++) {
+		for (int x = 0; x < t_rendered_cols; x++) {
+			rendered_grid[y][x].symbol = ' ';
+			rendered_grid[y][x].style = T_STYLE_UNKNOWN;
+		}
+	}
+
+	t_stats.scrolls++;
+}
+
+static bool t_cells_equal(Cell a, Cell b) {
+	return a.symbol == b.symbol && a.style == b.style;
+}
+
+static int t_row_next_change(Cell* old_row, Cell* new_row, int from, int to) {
+	int x = from;
+
+#if defined(__SSE2__)
+	int cells_per_vector = sizeof(__m128i) / sizeof(Cell);
+
+	for (; x + cells_per_vector <= to; x += cells_per_vector) {
+		__m128i old_cells = _mm_loadu_si128((__m128i*)(old_row + x));
+		__m128i new_cells = _mm_loadu_si128((__m128i*)(new_row + x));
+		int equal = _mm_movemask_epi8(_mm_cmpeq_epi8(old_cells, new_cells));
+
+		if (equal != 0xffff)
+			return x + __builtin_ctz(~equal) / sizeof(Cell);
+	}
+#endif
+
+	for (; x < to; x++) {
+		if (!t_cells_equal(old_row[x], new_row[x]))
+			return x;
+	}
+
+	return to;
+}
+
+void t_row_blit(TerminalRow* row, int x, Cell* cells, int count) {
+	int from = t_row_next_change(row->cells + x, cells, 0, count);
+
+	if (from == count)
+		return;
+
+	int to = count;
+
+	while (to > from && t_cells_equal(row->cells[x + to - 1], cells[to - 1]))
+		to--;
+
+	memcpy(row->cells + x + from, cells + from, sizeof(Cell) * (to - from));
+
+	t_damage_mark(row->damage, row->x + x + from);
+	t_damage_mark(row->damage, row->x + x + to - 1);
+}
+
+static void t_render_grid(Grid grid, TerminalDamage* damages, int rows, int cols) {
+	t_frame_reserve((size_t)rows * cols * 16);
+
+	t_frame_grid = grid;
+	t_stats.rows_damaged = 0;
+	t_stats.cells_visited = 0;
+
+	for (int y = 0; y < rows; y++) {
+		TerminalDamage damage = damages[y];
+
+		if (damage.from >= damage.to)
+			continue;
+
+		t_stats.rows_damaged++;
+		t_stats.cells_visited += damage.to - damage.from;
+
+		int x = t_row_next_change(rendered_grid[y], grid[y], damage.from, damage.to);
+
+		while (x < damage.to) {
+			t_frame_put_cell(x, y, cols, grid[y][x]);
+
+			x = t_row_next_change(rendered_grid[y], grid[y], x + 1, damage.to);
+		}
+	}
+}
+
+static void t_op_apply(TerminalOp op) {
+	switch (op.type) {
+		case T_OP_CLEAR_SCREEN:
+			t_apply_clear_screen();
+			break;
+
+		case T_OP_MOVE_CURSOR:
+			t_apply_move_cursor(op.x, op.y);
+			break;
+
+		case T_OP_SET_COLOR:
+			t_apply_set_color(op.color);
+			break;
+
+		case T_OP_SCROLL_ROWS:
+			t_apply_scroll_rows(op.top, op.bottom, op.count);
+			break;
+
+		case T_OP_INVALIDATE:
+			t_apply_invalidate();
+			break;
+
+		case T_OP_RESIZE:
+			t_apply_resize(op.rows, op.cols);
+			break;
+	}
+}
+
+static void t_op_list_push(TerminalOpList* list, TerminalOp op) {
+	if (list->count == list->capacity) {
+		list->capacity = MAX(8, list->capacity * 2);
+		list->items = (TerminalOp*)realloc(list->items, sizeof(TerminalOp) * list->capacity);
+	}
+
+	list->items[list->count++] = op;
+}
+
+static void t_op(TerminalOp op) {
+	if (t_thread.running)
+		t_op_list_push(&t_thread.ops, op);
+	else
+		t_op_apply(op);
 }
 
 void t_clear_screen() {
-	fprintf(stdout, "\e[1;1H\e[2J");
+	t_op((TerminalOp){.type = T_OP_CLEAR_SCREEN});
 }
 
 void t_move_cursor(int x, int y) {
-	fprintf(stdout, "\e[%d;%dH", y + 1, x + 1);
+	t_op((TerminalOp){.type = T_OP_MOVE_CURSOR, .x = x, .y = y});
 }
 
 void t_set_color(terminal_color color) {
-	fprintf(stdout, "%s", color);
+	t_op((TerminalOp){.type = T_OP_SET_COLOR, .color = color});
 }
 
-void t_render(int rows, int cols) {
-	for (int y = 0; y < rows; y++) {
-		for (int x = 0; x < cols; x++) {
-			Cell old_cell = rendered_grid[y][x];
-			Cell new_cell = current_grid[y][x];
+static int64_t t_clock_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
 
-			if (old_cell.symbol != new_cell.symbol || old_cell.color != new_cell.color) {
-				t_move_cursor(x, y);
+static void t_snapshot_fit(TerminalSnapshot* snapshot, int rows, int cols) {
+	if (snapshot->rows == rows && snapshot->cols == cols)
+		return;
 
-				t_set_color(*new_cell.color);
-				printf("%c", new_cell.symbol);
-			}
+	t_grid_free(snapshot->grid);
+	free(snapshot->damage);
+	free(snapshot->stale);
+
+	snapshot->grid = t_grid_new(rows, cols);
+	snapshot->damage = (TerminalDamage*)malloc(sizeof(TerminalDamage) * rows);
+	snapshot->stale = (TerminalDamage*)malloc(sizeof(TerminalDamage) * rows);
+	snapshot->rows = rows;
+	snapshot->cols = cols;
+
+	for (int y = 0; y < rows; y++)
+		snapshot->stale[y] = (TerminalDamage){.from = 0, .to = cols};
+}
+
+static void t_snapshot_fill(TerminalSnapshot* snapshot) {
+	t_snapshot_fit(snapshot, t_grid_rows, t_grid_cols);
+
+	for (int y = 0; y < t_grid_rows; y++) {
+		TerminalDamage copy = snapshot->stale[y];
+
+		t_damage_merge(&copy, t_damage[y]);
+
+		if (copy.from < copy.to)
+			memcpy(snapshot->grid[y] + copy.from, current_grid[y] + copy.from, sizeof(Cell) * (copy.to - copy.from));
+
+		snapshot->stale[y] = (TerminalDamage){.from = t_grid_cols, .to = 0};
+		snapshot->damage[y] = t_damage[y];
+
+		for (int i = 0; i < T_SNAPSHOTS; i++) {
+			TerminalSnapshot* other = &t_thread.snapshots[i];
+
+			if (other != snapshot && other->rows == t_grid_rows && other->cols == t_grid_cols)
+				t_damage_merge(&other->stale[y], t_damage[y]);
 		}
+
+		t_damage_clear(y);
 	}
 
-	fflush(stdout);
+	for (int i = 0; i < t_thread.ops.count; i++)
+		t_op_list_push(&snapshot->ops, t_thread.ops.items[i]);
+
+	t_thread.ops.count = 0;
+}
+
+static void t_snapshot_absorb(TerminalSnapshot* snapshot, TerminalSnapshot* dropped) {
+	for (int y = 0; y < snapshot->rows; y++) {
+		if (dropped->rows == snapshot->rows && dropped->cols == snapshot->cols)
+			t_damage_merge(&snapshot->damage[y], dropped->damage[y]);
+		else
+			snapshot->damage[y] = (TerminalDamage){.from = 0, .to = snapshot->cols};
+	}
+
+	for (int i = 0; i < snapshot->ops.count; i++)
+		t_op_list_push(&dropped->ops, snapshot->ops.items[i]);
+
+	TerminalOpList ops = snapshot->ops;
+	snapshot->ops = dropped->ops;
+	dropped->ops = ops;
+	dropped->ops.count = 0;
+}
+
+static void t_render_publish() {
+	pthread_mutex_lock(&t_thread.mutex);
+
+	int index = 0;
+
+	while (index == t_thread.front || index == t_thread.pending)
+		index++;
+
+	pthread_mutex_unlock(&t_thread.mutex);
+
+	TerminalSnapshot* snapshot = &t_thread.snapshots[index];
+
+	t_snapshot_fill(snapshot);
+
+	pthread_mutex_lock(&t_thread.mutex);
+
+	if (t_thread.pending >= 0) {
+		t_snapshot_absorb(snapshot, &t_thread.snapshots[t_thread.pending]);
+		t_thread.dropped++;
+	}
+
+	snapshot->published_ns = t_clock_ns();
+	t_thread.pending = index;
+	t_thread.published++;
+
+	pthread_cond_signal(&t_thread.frame_cond);
+	pthread_mutex_unlock(&t_thread.mutex);
+}
+
+static void t_render_snapshot(TerminalSnapshot* snapshot) {
+	for (int i = 0; i < snapshot->ops.count; i++)
+		t_op_apply(snapshot->ops.items[i]);
+
+	snapshot->ops.count = 0;
+
+	if (snapshot->rows == t_rendered_rows && snapshot->cols == t_rendered_cols) {
+		t_render_grid(snapshot->grid, snapshot->damage, snapshot->rows, snapshot->cols);
+
+		for (int y = 0; y < snapshot->rows; y++) {
+			TerminalDamage damage = snapshot->damage[y];
+
+			if (damage.from < damage.to)
+				memcpy(rendered_grid[y] + damage.from, snapshot->grid[y] + damage.from, sizeof(Cell) * (damage.to - damage.from));
+		}
+	}
+
+	t_frame_flush();
+}
+
+static void* t_render_thread_main(void* arg) {
+	pthread_mutex_lock(&t_thread.mutex);
+
+	while (true) {
+		while (t_thread.pending < 0 && !t_thread.stopping)
+			pthread_cond_wait(&t_thread.frame_cond, &t_thread.mutex);
+
+		if (t_thread.pending < 0)
+			break;
+
+		TerminalSnapshot* snapshot = &t_thread.snapshots[t_thread.pending];
+
+		t_thread.front = t_thread.pending;
+		t_thread.pending = -1;
+
+		pthread_mutex_unlock(&t_thread.mutex);
+
+		t_stats.queue_ns_last = t_clock_ns() - snapshot->published_ns;
+		t_stats.queue_ns_max = MAX(t_stats.queue_ns_max, t_stats.queue_ns_last);
+
+		t_render_snapshot(snapshot);
+
+		pthread_mutex_lock(&t_thread.mutex);
+
+		t_thread.front = -1;
+		t_thread.stats = t_stats;
+
+		pthread_cond_broadcast(&t_thread.idle_cond);
+	}
+
+	pthread_mutex_unlock(&t_thread.mutex);
+
+	return NULL;
+}
+
+void t_render_thread_start() {
+	t_thread.running = true;
+	t_thread.stats = t_stats;
+
+	pthread_create(&t_thread.thread, NULL, t_render_thread_main, NULL);
+}
+
+void t_render_thread_stop() {
+	if (!t_thread.running)
+		return;
+
+	pthread_mutex_lock(&t_thread.mutex);
+
+	t_thread.stopping = true;
+
+	pthread_cond_signal(&t_thread.frame_cond);
+	pthread_mutex_unlock(&t_thread.mutex);
+
+	pthread_join(t_thread.thread, NULL);
+
+	t_thread.running = false;
+	t_thread.stopping = false;
+
+	for (int i = 0; i < t_thread.ops.count; i++)
+		t_op_apply(t_thread.ops.items[i]);
+
+	t_thread.ops.count = 0;
+}
+
+void t_render_wait_idle() {
+	if (!t_thread.running)
+		return;
+
+	pthread_mutex_lock(&t_thread.mutex);
+
+	while (t_thread.pending >= 0 || t_thread.front >= 0)
+		pthread_cond_wait(&t_thread.idle_cond, &t_thread.mutex);
+
+	pthread_mutex_unlock(&t_thread.mutex);
+}
+
+void t_flush() {
+	t_render_wait_idle();
+
+	for (int i = 0; i < t_thread.ops.count; i++)
+		t_op_apply(t_thread.ops.items[i]);
+
+	t_thread.ops.count = 0;
+
+	if (t_frame.size > 0)
+		t_frame_flush();
+}
+
+TerminalStats t_stats_read() {
+	if (!t_thread.running) {
+		TerminalStats stats = t_stats;
+		stats.frames_published = t_stats.frames;
+
+		return stats;
+	}
+
+	pthread_mutex_lock(&t_thread.mutex);
+
+	TerminalStats stats = t_thread.stats;
+	stats.frames_published = t_thread.published;
+	stats.frames_dropped = t_thread.dropped;
+
+	pthread_mutex_unlock(&t_thread.mutex);
+
+	return stats;
+}
+
+void t_render(int rows, int cols) {
+	if (t_thread.running) {
+		t_render_publish();
+
+		return;
+	}
+
+	t_render_grid(current_grid, t_damage, rows, cols);
+	t_frame_flush();
 }
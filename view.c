@@ -6,6 +6,20 @@
 ViewT* view_new(int origin_x, int origin_y, int end_x, int end_y, ViewT* parent) {
 	ViewT* view =  (ViewT*)malloc(sizeof(ViewT));
 
+	view->parent = parent;
+
+	view_resize(view, origin_x, origin_y, end_x, end_y);
+
+	return view;
+}
+
+ViewT* view_new_embedded(ViewT* parent) {
+	return view_new(parent->origin.x, parent->origin.y, parent->end.x, parent->end.y, parent);
+}
+
+void view_resize(ViewT* view, int origin_x, int origin_y, int end_x, int end_y) {
+	ViewT* parent = view->parent;
+
 	if (parent != NULL) {
 		end_x = MIN(parent->end.x, end_x);
 		end_y = MIN(parent->end.y, end_y);
@@ -15,31 +29,45 @@ ViewT* view_new(int origin_x, int origin_y, int end_x, int end_y, ViewT* parent)
 	view->origin.y = origin_y;
 	view->end.x = end_x;
 	view->end.y = end_y;
-	view->parent = parent;
 
-	return view;
+	view_layout(view);
 }
 
-ViewT* view_new_embedded(ViewT* parent) {
-	return view_new(parent->origin.x, parent->origin.y, parent->end.x, parent->end.y, parent);
+void view_resize_embedded(ViewT* view) {
+	ViewT* parent = view->parent;
+
+	view_resize(view, parent->origin.x, parent->origin.y, parent->end.x, parent->end.y);
 }
 
-int view_x(ViewT* view, int x) {
-	while (view->parent != NULL) {
-		x += view->origin.x;
-		view = view->parent;
+void view_layout(ViewT* view) {
+	ViewT* parent = view->parent;
+
+	if (parent == NULL) {
+		view->absolute.x = 0;
+		view->absolute.y = 0;
+	} else {
+		view->absolute.x = parent->absolute.x + view->origin.x;
+		view->absolute.y = parent->absolute.y + view->origin.y;
 	}
 
-	return x;
-}
+	view->clip_origin = view->absolute;
+	view->clip_end.x = view->absolute.x + view_cols(view);
+	view->clip_end.y = view->absolute.y + view_rows(view);
 
-int view_y(ViewT* view, int y) {
-	while (view->parent != NULL) {
-		y += view->origin.y;
-		view = view->parent;
+	if (parent != NULL) {
+		view->clip_origin.x = MAX(view->clip_origin.x, parent->clip_origin.x);
+		view->clip_origin.y = MAX(view->clip_origin.y, parent->clip_origin.y);
+		view->clip_end.x = MIN(view->clip_end.x, parent->clip_end.x);
+		view->clip_end.y = MIN(view->clip_end.y, parent->clip_end.y);
 	}
+}
 
-	return y;
+int view_x(ViewT* view, int x) {
+	return view->absolute.x + x;
+}
+
+int view_y(ViewT* view, int y) {
+	return view->absolute.y + y;
 }
 
 int view_cols(ViewT* view) {
@@ -49,3 +77,11 @@ int view_cols(ViewT* view) {
 int view_rows(ViewT* view) {
 	return view->end.y - view->origin.y;
 }
+
+int view_visible_cols(ViewT* view) {
+	return MAX(0, view->clip_end.x - view->absolute.x);
+}
+
+int view_visible_rows(ViewT* view) {
+	return MAX(0, view->clip_end.y - view->absolute.y);
+}
@@ -7,12 +7,20 @@ typedef struct View {
 	Pos origin;
 	Pos end;
 	struct View* parent;
+	Pos absolute;
+	Pos clip_origin;
+	Pos clip_end;
 } ViewT;
 
 ViewT* view_new(int origin_x, int origin_y, int end_x, int end_y, ViewT* parent);
 ViewT* view_new_embedded(ViewT* parent);
+void view_resize(ViewT* view, int origin_x, int origin_y, int end_x, int end_y);
+void view_resize_embedded(ViewT* view);
+void view_layout(ViewT* view);
 
 int view_x(ViewT* view, int x);
 int view_y(ViewT* view, int x);
 int view_cols(ViewT* view);
 int view_rows(ViewT* view);
+int view_visible_cols(ViewT* view);
+int view_visible_rows(ViewT* view);
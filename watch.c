@@ -0,0 +1,70 @@
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#define WATCH_EVENTS (IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE)
+#define WATCH_READ_BUFFER_SIZE 4096
+
+static int watch_inotify_fd = -1;
+
+void watch_start() {
+	watch_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+}
+
+int watch_notify_fd() {
+	return watch_inotify_fd;
+}
+
+char* watch_basename(char* filename) {
+	char* slash = strrchr(filename, '/');
+
+	if (slash == NULL)
+		return filename;
+
+	return slash + 1;
+}
+
+int watch_add(char* filename) {
+	if (watch_inotify_fd < 0)
+		return -1;
+
+	char* slash = strrchr(filename, '/');
+	char* dir;
+
+	if (slash == NULL) {
+		dir = strdup(".");
+	} else if (slash == filename) {
+		dir = strdup("/");
+	} else {
+		dir = strndup(filename, slash - filename);
+	}
+
+	int wd = inotify_add_watch(watch_inotify_fd, dir, WATCH_EVENTS);
+
+	free(dir);
+
+	return wd;
+}
+
+void watch_read_events(void (*handle)(int wd, char* name, void* context), void* context) {
+	char events[WATCH_READ_BUFFER_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+	while (true) {
+		ssize_t n = read(watch_inotify_fd, events, sizeof(events));
+
+		if (n <= 0)
+			break;
+
+		for (char* p = events; p < events + n; ) {
+			struct inotify_event* event = (struct inotify_event*)p;
+
+			if (event->len > 0)
+				handle(event->wd, event->name, context);
+
+			p += sizeof(struct inotify_event) + event->len;
+		}
+	}
+}
@@ -0,0 +1,96 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define WRAP_CACHE_SLOTS 4096
+
+typedef struct {
+	uint64_t line_id;
+	uint32_t line_version;
+	int width;
+	int rows;
+	int capacity;
+	int* breaks;
+} WrapLayoutT;
+
+typedef struct {
+	WrapLayoutT entries[WRAP_CACHE_SLOTS];
+	uint64_t hits;
+	uint64_t misses;
+} WrapCacheT;
+
+WrapCacheT wrap_cache = {};
+
+static void wrap_layout_push(WrapLayoutT* layout, int column) {
+	if (layout->rows + 1 >= layout->capacity) {
+		layout->capacity = MAX(8, layout->capacity * 2);
+		layout->breaks = (int*)realloc(layout->breaks, sizeof(int) * layout->capacity);
+	}
+
+	layout->breaks[layout->rows++] = column;
+}
+
+static void wrap_layout_build(WrapLayoutT* layout, LineT* line, int width) {
+	int column = 0;
+	int row_start = 0;
+	int last_break = 0;
+
+	layout->rows = 0;
+	wrap_layout_push(layout, 0);
+
+	for (LineItemT* item = line->item_head; item != NULL; item = item->next) {
+		int symbol_width = item->symbol == '\t' ? RENDER_TAB_WIDTH : 1;
+
+		while (column + symbol_width - row_start > width && column > row_start) {
+			row_start = last_break > row_start ? last_break : column;
+			last_break = row_start;
+			wrap_layout_push(layout, row_start);
+		}
+
+		column += symbol_width;
+
+		if (item->symbol == ' ' || item->symbol == '\t')
+			last_break = column;
+	}
+
+	layout->breaks[layout->rows] = column;
+}
+
+WrapLayoutT* wrap_layout(LineT* line, int width) {
+	width = MAX(1, width);
+
+	uint64_t key = line->id * 0x9e3779b97f4a7c15ULL;
+	WrapLayoutT* layout = &wrap_cache.entries[(key ^ key >> 29) & (WRAP_CACHE_SLOTS - 1)];
+
+	if (layout->line_id == line->id && layout->line_version == line->version && layout->width == width) {
+		wrap_cache.hits++;
+
+		return layout;
+	}
+
+	wrap_cache.misses++;
+
+	wrap_layout_build(layout, line, width);
+
+	layout->line_id = line->id;
+	layout->line_version = line->version;
+	layout->width = width;
+
+	return layout;
+}
+
+int wrap_layout_row_of_column(WrapLayoutT* layout, int column) {
+	int low = 0;
+	int high = layout->rows - 1;
+
+	while (low < high) {
+		int mid = (low + high + 1) / 2;
+
+		if (layout->breaks[mid] <= column)
+			low = mid;
+		else
+			high = mid - 1;
+	}
+
+	return low;
+}